@@ -0,0 +1,100 @@
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "../src/mlp_predictor.h"
+
+using namespace std;
+
+/*
+ * Microbenchmark of the learned prediction against the kinematic one.
+ * A network of random weights (32-64-64-6) refines the constant velocity
+ * prediction of a dense 3-lane scene, the time of both is printed per frame.
+ */
+int main(int argc, char **argv)
+{
+  int n_vehicles = argc > 1 ? atoi(argv[1]) : 200;
+  int hidden = argc > 2 ? atoi(argv[2]) : 64;
+  int n_frames = 200;
+  double max_s = 6945.554;
+
+  mt19937 gen(42);
+  uniform_real_distribution<float> s_dist(-100.f, 250.f);
+  uniform_int_distribution<int> lane_dist(0, 2);
+  uniform_real_distribution<float> v_dist(15.f, 25.f);
+  uniform_real_distribution<float> vd_dist(-0.5f, 0.5f);
+  normal_distribution<float> w_dist(0.f, 0.1f);
+
+  vector<int> sizes = {MlpPredictor::num_features, hidden, hidden, hidden, hidden, 6};
+  vector<vector<float> > weights(3);
+  vector<vector<float> > biases(3);
+  for(int l = 0; l < 3; ++l)
+  {
+    weights[l].resize(sizes[2 * l] * sizes[2 * l + 1]);
+    biases[l].resize(sizes[2 * l + 1]);
+    for(float &w : weights[l])
+      w = w_dist(gen);
+    for(float &b : biases[l])
+      b = w_dist(gen);
+  }
+
+  LaneTopology lanes(max_s);
+  TrafficSnapshot traffic(lanes, n_vehicles);
+  Tracker tracker(max_s, 2 * n_vehicles, 1000.);
+  Prediction prediction(n_vehicles, 151, 0.02, CONSTANT_VELOCITY);
+  MlpPredictor mlp(n_vehicles);
+  if(!mlp.set_layers(sizes, weights, biases))
+  {
+    cout << "bad network\n";
+    return 1;
+  }
+
+  // every car gets a history before the frames are timed
+  vector<double> s0(n_vehicles), d0(n_vehicles), vs(n_vehicles), vd(n_vehicles);
+  for(int i = 0; i < n_vehicles; ++i)
+  {
+    s0[i] = 1000. + s_dist(gen);
+    d0[i] = 2 + 4 * lane_dist(gen);
+    vs[i] = v_dist(gen);
+    vd[i] = vd_dist(gen);
+  }
+
+  double cv_ms = 0.;
+  double mlp_ms = 0.;
+  double shift = 0.;
+  for(int f = 0; f < n_frames + MlpPredictor::history_len; ++f)
+  {
+    double t = f * 0.02;
+    traffic.reset(1000. + 20. * t);
+    tracker.begin_frame(t, 1000. + 20. * t);
+    for(int i = 0; i < n_vehicles; ++i)
+    {
+      double s = s0[i] + vs[i] * t;
+      double d = d0[i] + vd[i] * min(t, 1.);
+      tracker.update(i, s, d, vs[i], vd[i]);
+      traffic.add(i, 0., 0., 0., 0., s, d, vs[i], vd[i]);
+    }
+    traffic.finish();
+    tracker.end_frame();
+
+    auto start = chrono::steady_clock::now();
+    prediction.predict(traffic);
+    auto mid = chrono::steady_clock::now();
+    mlp.refine(traffic, tracker, prediction);
+    auto stop = chrono::steady_clock::now();
+
+    if(f < MlpPredictor::history_len)
+      continue;
+    cv_ms += chrono::duration<double, milli>(mid - start).count();
+    mlp_ms += chrono::duration<double, milli>(stop - mid).count();
+    for(int i = 0; i < prediction.size; ++i)
+      shift += fabs(mlp.ds(i, 2)) + fabs(mlp.dd(i, 2));
+  }
+
+  cout << n_vehicles << " vehicles, hidden " << hidden << " (" << mlp.kernel() << "): "
+    << "constant velocity " << cv_ms / n_frames << " ms, mlp "
+    << mlp_ms / n_frames << " ms per frame, mean correction at 3 s "
+    << shift / (n_frames * n_vehicles) << " m\n";
+
+  return 0;
+}
@@ -0,0 +1,71 @@
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "../src/obb_collision.h"
+
+using namespace std;
+
+/*
+ * Microbenchmark of the Cartesian collision checker.
+ * Runs a batch of candidate paths against a dense traffic scene on a
+ * straight 3-lane road and prints the time per frame.
+ */
+int main(int argc, char **argv)
+{
+  int n_vehicles = argc > 1 ? atoi(argv[1]) : 200;
+  int n_candidates = argc > 2 ? atoi(argv[2]) : 200;
+  int n_points = 150;
+  int n_frames = 200;
+
+  mt19937 gen(42);
+  uniform_real_distribution<float> s_dist(0.f, 1000.f);
+  uniform_int_distribution<int> lane_dist(0, 2);
+  uniform_real_distribution<float> v_dist(15.f, 25.f);
+  uniform_real_distribution<float> lat_dist(-4.f, 4.f);
+
+  ObbCollision obb(30, 0.1, n_vehicles);
+
+  // candidates start in the middle of the traffic and may drift laterally
+  vector<double> xs(n_candidates * n_points);
+  vector<double> ys(n_candidates * n_points);
+  for(int c = 0; c < n_candidates; ++c)
+  {
+    float v = v_dist(gen);
+    float lat = lat_dist(gen);
+    for(int k = 0; k < n_points; ++k)
+    {
+      float time = (k + 1) * 0.02f;
+      xs[c * n_points + k] = 500.f + v * time;
+      ys[c * n_points + k] = 6.f + lat * min(time / 2.f, 1.f);
+    }
+  }
+  vector<int> first_hit(n_candidates);
+  vector<int> cands(n_candidates);
+  for(int c = 0; c < n_candidates; ++c)
+    cands[c] = c;
+
+  double total_ms = 0;
+  int hits = 0;
+  for(int f = 0; f < n_frames; ++f)
+  {
+    obb.reset();
+    for(int i = 0; i < n_vehicles; ++i)
+      obb.add_vehicle(s_dist(gen), 2 + 4 * lane_dist(gen), v_dist(gen), 0.);
+
+    auto start = chrono::steady_clock::now();
+    obb.prepare();
+    obb.check_batch(xs.data(), ys.data(), n_points, cands.data(), n_candidates, first_hit.data());
+    auto stop = chrono::steady_clock::now();
+    total_ms += chrono::duration<double, milli>(stop - start).count();
+
+    for(int c = 0; c < n_candidates; ++c)
+      hits += first_hit[c] >= 0;
+  }
+
+  cout << n_vehicles << " vehicles, " << n_candidates << " candidates: "
+    << total_ms / n_frames << " ms per frame, "
+    << (double)hits / n_frames << " colliding candidates per frame\n";
+
+  return 0;
+}
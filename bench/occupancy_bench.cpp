@@ -0,0 +1,73 @@
+#include <chrono>
+#include <math.h>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "../src/occupancy.h"
+
+using namespace std;
+
+/*
+ * Microbenchmark of the frenet occupancy.
+ * Marks a dense traffic scene on the outer lanes of a 3-lane road, checks
+ * a batch of candidate ego trajectories in the free middle lane against it
+ * and prints the time per frame. No candidate collides, so every step of
+ * every candidate is checked.
+ */
+int main(int argc, char **argv)
+{
+  int n_vehicles = argc > 1 ? atoi(argv[1]) : 200;
+  int n_candidates = argc > 2 ? atoi(argv[2]) : 200;
+  int n_frames = 200;
+  double max_s = 6945.554;
+
+  mt19937 gen(42);
+  uniform_real_distribution<double> s_dist(-60., 190.);
+  uniform_int_distribution<int> lane_dist(0, 1);
+  uniform_real_distribution<double> v_dist(15., 25.);
+  uniform_real_distribution<double> lat_dist(-0.9, 0.9);
+
+  FrenetOccupancy occupancy(max_s);
+  int n_steps = occupancy.num_steps;
+
+  // candidates weave a little inside the middle lane
+  vector<double> ss(n_candidates * n_steps);
+  vector<double> ds(n_candidates * n_steps);
+  for(int c = 0; c < n_candidates; ++c)
+  {
+    double v = v_dist(gen);
+    double lat = lat_dist(gen);
+    for(int t = 0; t < n_steps; ++t)
+    {
+      double time = t * occupancy.dt;
+      ss[c * n_steps + t] = v * time;
+      ds[c * n_steps + t] = 6. + lat * sin(time);
+    }
+  }
+
+  double mark_ms = 0;
+  double check_ms = 0;
+  int hits = 0;
+  for(int f = 0; f < n_frames; ++f)
+  {
+    auto start = chrono::steady_clock::now();
+    occupancy.reset(0.);
+    for(int i = 0; i < n_vehicles; ++i)
+      occupancy.add_vehicle(s_dist(gen), 2 + 8 * lane_dist(gen), v_dist(gen));
+    auto marked = chrono::steady_clock::now();
+
+    for(int c = 0; c < n_candidates; ++c)
+      hits += occupancy.first_collision(&ss[c * n_steps], &ds[c * n_steps], n_steps) >= 0;
+    auto stop = chrono::steady_clock::now();
+
+    mark_ms += chrono::duration<double, milli>(marked - start).count();
+    check_ms += chrono::duration<double, milli>(stop - marked).count();
+  }
+
+  cout << n_vehicles << " vehicles, " << n_candidates << " candidates: "
+    << (mark_ms + check_ms) / n_frames << " ms per frame (marking "
+    << mark_ms / n_frames << " ms, checking " << check_ms / n_frames << " ms), "
+    << (double)hits / n_frames << " colliding candidates per frame\n";
+
+  return 0;
+}
@@ -0,0 +1,73 @@
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "../src/particle_predictor.h"
+
+using namespace std;
+
+/*
+ * Microbenchmark of the Monte Carlo prediction.
+ * Samples, propagates and counts the particles of a dense 3-lane scene,
+ * some cars drifting across their lane, and prints the time per frame
+ * with and without the worker pool.
+ */
+int main(int argc, char **argv)
+{
+  int n_vehicles = argc > 1 ? atoi(argv[1]) : 100;
+  int n_particles = argc > 2 ? atoi(argv[2]) : 64;
+  int n_frames = 200;
+  double max_s = 6945.554;
+
+  mt19937 gen(42);
+  uniform_real_distribution<float> s_dist(-60.f, 180.f);
+  uniform_int_distribution<int> lane_dist(0, 2);
+  uniform_real_distribution<float> v_dist(15.f, 25.f);
+  uniform_real_distribution<float> a_dist(-1.f, 1.f);
+  uniform_real_distribution<float> vd_dist(-1.f, 1.f);
+
+  LaneTopology lanes(max_s);
+  TrafficSnapshot traffic(lanes, n_vehicles, 100., 250.);
+  WorkerPool pool;
+  ParticlePredictor serial(max_s, nullptr, n_vehicles, n_particles);
+  ParticlePredictor parallel(max_s, &pool, n_vehicles, n_particles);
+
+  double serial_ms = 0.;
+  double parallel_ms = 0.;
+  double risk = 0.;
+  vector<double> ego_s(serial.num_steps), ego_d(serial.num_steps);
+  for(int f = 0; f < n_frames; ++f)
+  {
+    double origin = 1000. + f;
+    traffic.reset(origin);
+    for(int i = 0; i < n_vehicles; ++i)
+    {
+      double vd = lane_dist(gen) == 0 ? vd_dist(gen) : 0.;
+      traffic.add(i, 0., 0., 0., 0., origin + s_dist(gen), 2 + 4 * lane_dist(gen),
+                  v_dist(gen), vd, a_dist(gen));
+    }
+    traffic.finish();
+
+    auto start = chrono::steady_clock::now();
+    serial.predict(traffic, origin);
+    auto mid = chrono::steady_clock::now();
+    parallel.predict(traffic, origin);
+    auto stop = chrono::steady_clock::now();
+    serial_ms += chrono::duration<double, milli>(mid - start).count();
+    parallel_ms += chrono::duration<double, milli>(stop - mid).count();
+
+    for(int t = 0; t < serial.num_steps; ++t)
+    {
+      ego_s[t] = origin + 20. * t * serial.dt;
+      ego_d[t] = 6.;
+    }
+    risk += parallel.path_risk(ego_s.data(), ego_d.data(), serial.num_steps);
+  }
+
+  cout << n_vehicles << " vehicles, " << n_particles << " particles: "
+    << serial_ms / n_frames << " ms serial, "
+    << parallel_ms / n_frames << " ms on " << pool.size() << " threads per frame, "
+    << "mean risk of the middle lane " << risk / n_frames << "\n";
+
+  return 0;
+}
@@ -0,0 +1,97 @@
+#include <algorithm>
+#include <chrono>
+#include "behavior_layer.h"
+
+/*
+ * Initialize LayerMetrics
+ */
+
+LayerMetrics::LayerMetrics()
+{
+  runs = 0;
+  last_ms = 0.;
+  mean_ms = 0.;
+  max_ms = 0.;
+}
+
+
+void LayerMetrics::add(double ms)
+{
+  last_ms = ms;
+  mean_ms = runs > 0 ? 0.9 * mean_ms + 0.1 * ms : ms;
+  max_ms = std::max(max_ms, ms);
+  ++runs;
+}
+
+/*
+ * Initialize BehaviorInput
+ */
+
+BehaviorInput::BehaviorInput(const TrafficSnapshot &traffic, const LaneGapIndex &gaps,
+                             const Prediction &prediction)
+  : traffic(traffic), gaps(gaps), prediction(prediction)
+{
+  this->frame = -1;
+  this->stamp = 0.;
+  this->keep_duration = 0.01;
+  this->spacing = 30.;
+}
+
+/*
+ * Initialize BehaviorDecision
+ */
+
+BehaviorDecision::BehaviorDecision()
+{
+  frame = -1;
+  stamp = 0.;
+  lane = -1;
+  search_depth = 0;
+  search_ms = 0.;
+}
+
+/*
+ * Initialize PeriodicLayer
+ */
+
+PeriodicLayer::PeriodicLayer(double rate_hz)
+{
+  this->rate_hz = rate_hz;
+  running_ = false;
+}
+
+
+PeriodicLayer::~PeriodicLayer()
+{
+  stop();
+}
+
+
+void PeriodicLayer::start(const std::function<void()> &step)
+{
+  stop();
+  running_ = true;
+  thread_ = std::thread([this, step]()
+  {
+    auto period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(1. / rate_hz));
+    auto next = std::chrono::steady_clock::now();
+    while(running_)
+    {
+      step();
+      next += period;
+      auto now = std::chrono::steady_clock::now();
+      if(next < now)
+        next = now;
+      std::this_thread::sleep_until(next);
+    }
+  });
+}
+
+
+void PeriodicLayer::stop()
+{
+  running_ = false;
+  if(thread_.joinable())
+    thread_.join();
+}
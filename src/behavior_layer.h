@@ -0,0 +1,103 @@
+#ifndef BEHAVIOR_LAYER_H
+#define BEHAVIOR_LAYER_H
+#include <atomic>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+#include "vehicle.h"
+#include "traffic.h"
+#include "lane_gap.h"
+#include "prediction.h"
+
+using std::string;
+using std::vector;
+
+/*
+ * Timing of one layer of the planner.
+ */
+struct LayerMetrics
+{
+  long runs;       // steps the layer ran
+  double last_ms;  // time of the last step
+  double mean_ms;  // smoothed time of a step
+  double max_ms;   // longest step so far
+
+  LayerMetrics();
+
+  // count a step which took ms milliseconds
+  void add(double ms);
+};
+
+/*
+ * What the behavior layer decides on, published by the trajectory layer.
+ */
+struct BehaviorInput
+{
+  long frame;            // trajectory frame it was taken in
+  double stamp;          // wall time of that frame [s]
+  Vehicle ego;
+  double keep_duration;  // how long we have been in the current lane [s]
+  double spacing;        // distance between the spline anchors [m]
+  TrafficSnapshot traffic;
+  LaneGapIndex gaps;
+  Prediction prediction;
+
+  // the arrays are copied from these, so they keep their size
+  BehaviorInput(const TrafficSnapshot &traffic, const LaneGapIndex &gaps,
+                const Prediction &prediction);
+};
+
+/*
+ * What the behavior layer decided, taken by the trajectory layer.
+ * Lanes are absolute, so a decision stays valid after a lane change.
+ */
+struct BehaviorDecision
+{
+  long frame;                // trajectory frame of the input, -1 before the first decision
+  double stamp;              // wall time of that frame [s]
+  int lane;                  // lane to go to
+  vector<double> lane_cost;  // cost of going to each lane, 1e9 if it is no next state
+  int search_depth;          // maneuvers of the deepest sequences searched
+  double search_ms;          // lookahead over maneuver sequences
+  LayerMetrics metrics;      // timing of the behavior layer up to this decision
+  string report;             // costs of the next states for the console
+
+  BehaviorDecision();
+
+  // cost of going to lane ln
+  double cost(int ln) const
+  {
+    return ln >= 0 && ln < (int)lane_cost.size() ? lane_cost[ln] : 1e9;
+  }
+};
+
+/*
+ * A layer of the planner running on its own thread at a fixed rate.
+ *
+ * step() is called every 1 / rate_hz seconds; if a step takes longer, the
+ * next one starts right after it instead of catching up. The layer gets
+ * its input and hands over its output through double buffers, so it
+ * never blocks the layers running at other rates.
+ */
+class PeriodicLayer
+{
+public:
+  double rate_hz;
+
+  /*
+   * Constructor
+   */
+  PeriodicLayer(double rate_hz=10.);
+  ~PeriodicLayer();
+
+  // run step on the thread of the layer until stop()
+  void start(const std::function<void()> &step);
+  void stop();
+
+private:
+  std::thread thread_;
+  std::atomic<bool> running_;
+};
+
+#endif
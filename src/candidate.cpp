@@ -0,0 +1,82 @@
+#include <algorithm>
+#include "candidate.h"
+
+void StageMetrics::reset()
+{
+  generated = 0;
+  pruned = 0;
+  feasible = 0;
+  collision_free = 0;
+  cut_off = 0;
+  search_depth = 0;
+  deadline_missed = false;
+  prediction_ms = 0.;
+  feasibility_ms = 0.;
+  collision_ms = 0.;
+  search_ms = 0.;
+  speed_ms = 0.;
+  mpc_iterations = 0;
+}
+
+/*
+ * Initialize CandidateBatch
+ */
+
+CandidateBatch::CandidateBatch(int capacity, int n_points)
+{
+  this->n_points = n_points;
+  this->size = 0;
+
+  x.reserve(capacity * n_points);
+  y.reserve(capacity * n_points);
+  state.reserve(capacity);
+  lane.reserve(capacity);
+  bound.reserve(capacity);
+  cost.reserve(capacity);
+  first_hit.reserve(capacity);
+  near_hit.reserve(capacity);
+  survivors.reserve(capacity);
+  order.reserve(capacity);
+}
+
+
+void CandidateBatch::clear(int n_points)
+{
+  this->n_points = n_points;
+  this->size = 0;
+
+  x.clear();
+  y.clear();
+  state.clear();
+  lane.clear();
+  bound.clear();
+  cost.clear();
+  first_hit.clear();
+  near_hit.clear();
+  survivors.clear();
+  order.clear();
+}
+
+
+int CandidateBatch::add(State st, int lane, double bound)
+{
+  x.resize((size + 1) * n_points);
+  y.resize((size + 1) * n_points);
+  this->state.push_back(st);
+  this->lane.push_back(lane);
+  this->bound.push_back(bound);
+  cost.push_back(1e9);
+  first_hit.push_back(-1);
+  near_hit.push_back(-1);
+  survivors.push_back(size);
+
+  return size++;
+}
+
+
+void CandidateBatch::set_path(int c, const vector<double> &xs, const vector<double> &ys)
+{
+  int n = std::min((int)std::min(xs.size(), ys.size()), n_points);
+  std::copy(xs.begin(), xs.begin() + n, x.begin() + c * n_points);
+  std::copy(ys.begin(), ys.begin() + n, y.begin() + c * n_points);
+}
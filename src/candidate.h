@@ -0,0 +1,158 @@
+#ifndef CANDIDATE_H
+#define CANDIDATE_H
+#include <algorithm>
+#include <vector>
+#include "vehicle.h"
+#include "deadline.h"
+
+using std::vector;
+
+/*
+ * Counters and timing of the candidate evaluation stages of one frame.
+ */
+struct StageMetrics
+{
+  int generated;        // candidates put into the batch
+  int pruned;           // candidates skipped because of their lower bound
+  int feasible;         // candidates left after the kinematic check
+  int collision_free;   // candidates left after the collision check
+  int cut_off;          // candidates never evaluated because the deadline expired
+  int search_depth;     // maneuvers of the deepest sequences searched
+  bool deadline_missed; // the frame was sent after its budget
+  double prediction_ms;
+  double feasibility_ms;
+  double collision_ms;
+  double search_ms;     // lookahead over maneuver sequences
+  double speed_ms;      // speed profile of the chosen lane
+  int mpc_iterations;   // solver iterations of the speed tracking
+
+  void reset();
+
+  // share of the generated candidates which never went through the stages
+  double prune_rate() const { return generated > 0 ? (double)pruned / generated : 0.; }
+};
+
+/*
+ * A batch of candidate paths in SoA form.
+ *
+ * The (x,y) points of all candidates share one array each, candidate by
+ * candidate (x[c * n_points + k]), so every stage runs over contiguous
+ * memory. Stages never erase candidates, they shrink `survivors` so the
+ * next stage only sees the candidates that are still alive.
+ */
+class CandidateBatch
+{
+public:
+  int n_points;   // number of points of every candidate path
+  int size;       // number of candidates in the batch
+
+  vector<double> x;
+  vector<double> y;
+  vector<State> state;  // maneuver which produced the candidate
+  vector<int> lane;     // target lane of the candidate
+  vector<double> bound; // cheap lower bound of the cost
+  vector<double> cost;  // exact cost, only known for evaluated candidates
+  vector<int> first_hit;  // first colliding point, -1 if the path is free
+  vector<int> near_hit;   // first point passing a car too close, -1 if none
+
+  vector<int> survivors;
+  vector<int> order;  // candidates sorted by their bound
+
+  /*
+   * Constructor
+   */
+  CandidateBatch(int capacity=16, int n_points=50);
+
+  // drop all candidates, the next paths will have n_points points
+  void clear(int n_points);
+
+  // append a candidate without its path yet and return its index
+  int add(State st, int lane, double bound=0.);
+
+  // store the path of candidate c, extra points are cut off
+  void set_path(int c, const vector<double> &xs, const vector<double> &ys);
+
+  const double *xs(int c) const { return &x[c * n_points]; }
+  const double *ys(int c) const { return &y[c * n_points]; }
+};
+
+/*
+ * Branch-and-bound over a candidate batch.
+ *
+ * Candidates are sorted by their lower bound and evaluated in that order
+ * with exact(c), which runs the per-candidate stages and returns the
+ * exact cost (a huge value for a rejected candidate). Once a bound can't
+ * beat the best exact cost, the remaining candidates are left out. Then
+ * check(batch) runs the batched stages once over all evaluated candidates
+ * in `survivors`: it drops the ones it rejects and may raise the cost of
+ * the others, never lower it. If that makes the best cost worse, the
+ * candidates left out before get their turn. Returns the best candidate,
+ * or -1 if every evaluated candidate was rejected.
+ * With a deadline, the candidates left when it expires are cut off; the
+ * first candidate is always evaluated.
+ */
+template<typename Exact, typename Check>
+int branch_and_bound(CandidateBatch &batch, StageMetrics &metrics, Exact exact, Check check,
+                     double reject_cost=1e9, const Deadline *deadline=nullptr)
+{
+  vector<int> &order = batch.order;
+  order.clear();
+  for(int c = 0; c < batch.size; ++c)
+    order.push_back(c);
+  std::stable_sort(order.begin(), order.end(),
+                   [&batch](int a, int b) { return batch.bound[a] < batch.bound[b]; });
+
+  metrics.generated = batch.size;
+  int n = order.size();
+  int best = -1;
+  double best_cost = reject_cost;
+  int i = 0;
+  bool cut = false;
+  while(i < n && !cut)
+  {
+    // exact costs in bound order until a bound can't beat the best one
+    int first = i;
+    double round_cost = best_cost;
+    for(; i < n; ++i)
+    {
+      int c = order[i];
+      if(batch.bound[c] >= round_cost)
+        break;
+      if(i > 0 && deadline && deadline->expired())
+      {
+        cut = true;
+        break;
+      }
+      batch.cost[c] = exact(c);
+      round_cost = std::min(round_cost, batch.cost[c]);
+    }
+
+    batch.survivors.clear();
+    for(int j = first; j < i; ++j)
+    {
+      if(batch.cost[order[j]] < reject_cost)
+        batch.survivors.push_back(order[j]);
+    }
+    if(batch.survivors.empty())
+      break;
+
+    check(batch);
+    for(int c : batch.survivors)
+    {
+      if(batch.cost[c] < best_cost)
+      {
+        best_cost = batch.cost[c];
+        best = c;
+      }
+    }
+  }
+
+  if(cut)
+    metrics.cut_off += n - i;
+  else
+    metrics.pruned += n - i;
+
+  return best;
+}
+
+#endif
@@ -0,0 +1,132 @@
+#ifndef COST_H
+#define COST_H
+#include <algorithm>
+#include <tuple>
+#include <vector>
+
+using std::vector;
+
+/*
+ * Inputs of the cost terms for a batch of candidates in SoA form.
+ * Entry i of every array belongs to candidate i.
+ */
+struct CostInputs
+{
+  int size;
+  const double *front_dist;   // gap to the nearest car ahead in the target lane [m]
+  const double *back_dist;    // gap to the nearest car behind in the target lane [m]
+  const double *lane_change;  // 1 for a lane change, 0 for keep lane
+  const double *lane_busy;    // 1 if there is any car in the target lane
+  double keep_duration;       // how long we have been in the current lane [s]
+};
+
+/*
+ * Cost terms. Every term is a small functor returning the unweighted cost
+ * of candidate i, the engine inlines it into one loop over the batch.
+ * Terms are masked by multiplying with 0 or 1, so every divisor is kept
+ * away from 0 first: a car level with us would give 0 * inf = NaN.
+ */
+
+// 1 / x for a gap or a duration that may be 0
+inline double inv_clamped(double x)
+{
+  return 1. / std::max(x, 1e-3);
+}
+
+// stay behind a close car in our own lane
+struct KeepLaneGapCost
+{
+  double operator()(const CostInputs &in, int i) const
+  {
+    return (1. - in.lane_change[i]) * in.lane_busy[i] * inv_clamped(in.front_dist[i]);
+  }
+};
+
+// squeeze between two cars of the target lane
+struct ChangeLaneGapCost
+{
+  double operator()(const CostInputs &in, int i) const
+  {
+    return in.lane_change[i] * in.lane_busy[i] *
+           (inv_clamped(in.front_dist[i]) + inv_clamped(in.back_dist[i]));
+  }
+};
+
+// change lane again shortly after the last change
+struct ChangeLaneDurationCost
+{
+  double operator()(const CostInputs &in, int i) const
+  {
+    return in.lane_change[i] * in.lane_busy[i] * inv_clamped(in.keep_duration);
+  }
+};
+
+/*
+ * A cost term scaled by its weight.
+ */
+template<typename Term>
+struct Weighted
+{
+  Term term;
+  double weight;
+
+  Weighted(double w=1.) : term(), weight(w) {}
+};
+
+/*
+ * Cost engine composed of weighted terms at compile time.
+ *
+ *   CostEngine<Weighted<KeepLaneGapCost>, Weighted<ChangeLaneGapCost>> engine(
+ *       Weighted<KeepLaneGapCost>(60.), Weighted<ChangeLaneGapCost>(30.));
+ *
+ * Every term runs as its own tight loop over the whole batch and is fully
+ * inlined, there is no virtual call. A term that is not part of the type
+ * costs nothing. Debug builds also keep the weighted cost of every term
+ * per candidate in `breakdown` to see why a candidate won.
+ */
+template<typename... Terms>
+class CostEngine
+{
+public:
+  static const int num_terms = sizeof...(Terms);
+
+  std::tuple<Terms...> terms;
+
+#ifndef NDEBUG
+  vector<double> breakdown[sizeof...(Terms)];
+#endif
+
+  CostEngine(Terms... ts) : terms(ts...) {}
+
+  // write the total cost of every candidate of the batch into cost
+  void evaluate(const CostInputs &in, double *cost)
+  {
+    for(int i = 0; i < in.size; ++i)
+      cost[i] = 0.;
+    add_term<0>(in, cost, std::integral_constant<bool, (num_terms > 0)>());
+  }
+
+private:
+  template<int N>
+  void add_term(const CostInputs &in, double *cost, std::true_type)
+  {
+    const auto &t = std::get<N>(terms);
+#ifndef NDEBUG
+    breakdown[N].resize(in.size);
+    for(int i = 0; i < in.size; ++i)
+    {
+      breakdown[N][i] = t.weight * t.term(in, i);
+      cost[i] += breakdown[N][i];
+    }
+#else
+    for(int i = 0; i < in.size; ++i)
+      cost[i] += t.weight * t.term(in, i);
+#endif
+    add_term<N + 1>(in, cost, std::integral_constant<bool, (N + 1 < num_terms)>());
+  }
+
+  template<int N>
+  void add_term(const CostInputs &, double *, std::false_type) {}
+};
+
+#endif
@@ -0,0 +1,37 @@
+#include "deadline.h"
+
+/*
+ * Initialize Deadline
+ */
+
+Deadline::Deadline(double budget_ms)
+{
+  this->budget_ms = budget_ms;
+  this->hits = 0;
+  this->misses = 0;
+  this->start_ = std::chrono::steady_clock::now();
+}
+
+
+void Deadline::start()
+{
+  start_ = std::chrono::steady_clock::now();
+}
+
+
+double Deadline::elapsed_ms() const
+{
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_).count();
+}
+
+
+bool Deadline::finish()
+{
+  bool in_time = !expired();
+  if(in_time)
+    ++hits;
+  else
+    ++misses;
+
+  return in_time;
+}
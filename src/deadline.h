@@ -0,0 +1,39 @@
+#ifndef DEADLINE_H
+#define DEADLINE_H
+#include <chrono>
+
+/*
+ * Time budget of one planning frame.
+ *
+ * start() is called when telemetry arrives, the stages which can refine
+ * progressively check expired() between their steps and return the best
+ * they have found. finish() is called right before the path is sent and
+ * counts whether the frame made it in time.
+ */
+class Deadline
+{
+public:
+  double budget_ms;  // time from telemetry to sending the path [ms]
+  int hits;          // frames sent within the budget
+  int misses;        // frames sent after it
+
+  /*
+   * Constructor
+   */
+  Deadline(double budget_ms=10.);
+
+  // start the budget of a new frame now
+  void start();
+
+  bool expired() const { return elapsed_ms() >= budget_ms; }
+  double elapsed_ms() const;
+  double remaining_ms() const { return budget_ms - elapsed_ms(); }
+
+  // close the frame, returns true if it was in time
+  bool finish();
+
+private:
+  std::chrono::steady_clock::time_point start_;
+};
+
+#endif
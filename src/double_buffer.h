@@ -0,0 +1,51 @@
+#ifndef DOUBLE_BUFFER_H
+#define DOUBLE_BUFFER_H
+#include <atomic>
+#include <vector>
+
+/*
+ * Lock-free double buffer between one writer thread and one reader thread.
+ *
+ * The writer fills its back copy in place and publishes it, the reader
+ * takes the latest published copy as its front and keeps reading it until
+ * it asks for a newer one. The two copies swap through a spare slot with
+ * a single atomic exchange, so neither side ever waits for the other and
+ * a copy is never written while it is read. Values the reader skipped are
+ * simply overwritten, only the latest one matters.
+ */
+template<typename T>
+class DoubleBuffer
+{
+public:
+  DoubleBuffer(const T &init=T()) : slots_(3, init), back_(0), front_(1), spare_(2) {}
+
+  // writer: the copy to fill, then publish() it
+  T &back() { return slots_[back_]; }
+
+  void publish()
+  {
+    back_ = spare_.exchange(back_ | fresh_bit) & index_mask;
+  }
+
+  // reader: take the latest published copy, returns false if there is none
+  bool update()
+  {
+    if(!(spare_.load(std::memory_order_relaxed) & fresh_bit))
+      return false;
+    front_ = spare_.exchange(front_) & index_mask;
+    return true;
+  }
+
+  const T &front() const { return slots_[front_]; }
+
+private:
+  static const int fresh_bit = 4;
+  static const int index_mask = 3;
+
+  std::vector<T> slots_;
+  int back_;                // only touched by the writer
+  int front_;               // only touched by the reader
+  std::atomic<int> spare_;  // slot in between, fresh_bit if it holds a new copy
+};
+
+#endif
@@ -0,0 +1,13 @@
+#include "emitted_path.h"
+
+bool EmittedPath::sync(int prev_size)
+{
+  if(prev_size > points_.size())
+  {
+    points_.clear();
+    return false;
+  }
+
+  points_.pop_front(points_.size() - prev_size);
+  return true;
+}
@@ -0,0 +1,58 @@
+#ifndef EMITTED_PATH_H
+#define EMITTED_PATH_H
+#include "ring_buffer.h"
+
+/*
+ * A point of a path we sent, with the state the car will have there.
+ */
+struct PathPoint
+{
+  double x, y;    // world coordination
+  double s, d;    // frenet coordination
+  double v, a;    // speed and acceleration along the path [m/s, m/s^2]
+  double vd, ad;  // lateral speed and acceleration [m/s, m/s^2]
+};
+
+/*
+ * The points we sent to the simulator which it hasn't driven yet.
+ *
+ * The simulator drives our path from its front and reports how many
+ * points are left, so the number of previous path points is all we need
+ * to know which of our points are still ahead; their coordinates and
+ * states come from here instead of the telemetry. The last point is the
+ * exact state the next path starts from.
+ */
+class EmittedPath
+{
+public:
+  static const int capacity = 256;
+
+  /*
+   * The simulator has prev_size of our points left, forget the driven ones.
+   * Returns false, with an empty buffer, if it has points we don't know of,
+   * e.g. when the planner was restarted while the simulator kept running.
+   */
+  bool sync(int prev_size);
+
+  // drop the n oldest points, which the car drives before a new path arrives
+  void drop(int n) { points_.pop_front(n); }
+
+  // keep only the n oldest points
+  void truncate(int n)
+  {
+    if(n < points_.size())
+      points_.pop_back(points_.size() - n);
+  }
+
+  void push(const PathPoint &p) { points_.push(p); }
+
+  int size() const { return points_.size(); }
+  bool empty() const { return points_.empty(); }
+  const PathPoint &operator[](int i) const { return points_[i]; }
+  const PathPoint &back() const { return points_.back(); }
+
+private:
+  RingBuffer<PathPoint, capacity> points_;
+};
+
+#endif
@@ -0,0 +1,153 @@
+#include <algorithm>
+#include <math.h>
+#include "feasibility.h"
+
+/*
+ * Initialize FeasibilityChecker
+ */
+
+FeasibilityChecker::FeasibilityChecker(double max_acc, double max_jerk, double max_step_jerk,
+                                       double dt, double window)
+{
+  this->max_acc = max_acc;
+  this->max_jerk = max_jerk;
+  this->max_step_jerk = max_step_jerk;
+  this->dt = dt;
+  this->window = window;
+  this->w_acc = 10.;
+  this->w_jerk = 10.;
+}
+
+
+void FeasibilityChecker::measure(const CandidateBatch &batch)
+{
+  int n = batch.n_points;
+  peak_acc.resize(batch.size);
+  peak_acc_t.resize(batch.size);
+  peak_acc_n.resize(batch.size);
+  peak_jerk.resize(batch.size);
+  avg_acc.resize(batch.size);
+  avg_jerk.resize(batch.size);
+  if((int)vx_.size() < n)
+  {
+    vx_.resize(n);
+    vy_.resize(n);
+    ax_.resize(n);
+    ay_.resize(n);
+  }
+
+  for(int c : batch.survivors)
+    measure_one(batch.xs(c), batch.ys(c), n, c);
+}
+
+
+void FeasibilityChecker::measure_one(const double *x, const double *y, int n, int c)
+{
+  peak_acc[c] = 0.;
+  peak_acc_t[c] = 0.;
+  peak_acc_n[c] = 0.;
+  peak_jerk[c] = 0.;
+  avg_acc[c] = 0.;
+  avg_jerk[c] = 0.;
+  if(n < 4)
+    return;
+
+  const double inv_dt = 1. / dt;
+  double *vx = vx_.data(), *vy = vy_.data();
+  double *ax = ax_.data(), *ay = ay_.data();
+
+  // finite differences, every loop is a straight pass the compiler vectorizes
+  for(int k = 0; k < n - 1; ++k)
+  {
+    vx[k] = (x[k + 1] - x[k]) * inv_dt;
+    vy[k] = (y[k + 1] - y[k]) * inv_dt;
+  }
+  for(int k = 0; k < n - 2; ++k)
+  {
+    ax[k] = (vx[k + 1] - vx[k]) * inv_dt;
+    ay[k] = (vy[k + 1] - vy[k]) * inv_dt;
+  }
+
+  // split the acceleration along and across the heading between both velocities
+  double acc_t = 0., acc_n = 0., acc = 0.;
+  for(int k = 0; k < n - 2; ++k)
+  {
+    double hx = vx[k] + vx[k + 1];
+    double hy = vy[k] + vy[k + 1];
+    double inv_norm = 1. / sqrt(hx * hx + hy * hy + 1e-12);
+    double t = fabs(ax[k] * hx + ay[k] * hy) * inv_norm;
+    double nn = fabs(ay[k] * hx - ax[k] * hy) * inv_norm;
+    acc_t = t > acc_t ? t : acc_t;
+    acc_n = nn > acc_n ? nn : acc_n;
+    double a = ax[k] * ax[k] + ay[k] * ay[k];
+    acc = a > acc ? a : acc;
+  }
+
+  double jerk = 0.;
+  for(int k = 0; k < n - 3; ++k)
+  {
+    double jx = (ax[k + 1] - ax[k]) * inv_dt;
+    double jy = (ay[k + 1] - ay[k]) * inv_dt;
+    double j = jx * jx + jy * jy;
+    jerk = j > jerk ? j : jerk;
+  }
+
+  // acceleration averaged over the window is the change of velocity across it,
+  // a path shorter than the window is averaged over its whole length
+  int w = std::min(std::max((int)lround(window / dt), 1), n - 3);
+  double inv_w = inv_dt / w;
+  double a_avg = 0., j_avg = 0.;
+  double prev_x = (vx[w] - vx[0]) * inv_w;
+  double prev_y = (vy[w] - vy[0]) * inv_w;
+  a_avg = sqrt(prev_x * prev_x + prev_y * prev_y);
+  for(int k = 1; k + w < n - 1; ++k)
+  {
+    double cur_x = (vx[k + w] - vx[k]) * inv_w;
+    double cur_y = (vy[k + w] - vy[k]) * inv_w;
+    double a = sqrt(cur_x * cur_x + cur_y * cur_y);
+    double jx = (cur_x - prev_x) * inv_dt;
+    double jy = (cur_y - prev_y) * inv_dt;
+    double j = sqrt(jx * jx + jy * jy);
+    a_avg = a > a_avg ? a : a_avg;
+    j_avg = j > j_avg ? j : j_avg;
+    prev_x = cur_x;
+    prev_y = cur_y;
+  }
+
+  peak_acc[c] = sqrt(acc);
+  peak_acc_t[c] = acc_t;
+  peak_acc_n[c] = acc_n;
+  peak_jerk[c] = sqrt(jerk);
+  avg_acc[c] = a_avg;
+  avg_jerk[c] = j_avg;
+}
+
+
+bool FeasibilityChecker::feasible(int c) const
+{
+  return peak_acc[c] <= max_acc && avg_acc[c] <= max_acc &&
+         avg_jerk[c] <= max_jerk && peak_jerk[c] <= max_step_jerk;
+}
+
+
+double FeasibilityChecker::margin_cost(int c) const
+{
+  // squared shares of the limits, a calm path costs next to nothing
+  double acc = std::max(peak_acc[c], avg_acc[c]) / max_acc;
+  double jerk = avg_jerk[c] / max_jerk;
+  double step_jerk = peak_jerk[c] / max_step_jerk;
+  return w_acc * acc * acc + w_jerk * (jerk * jerk + step_jerk * step_jerk);
+}
+
+
+int FeasibilityChecker::filter(CandidateBatch &batch)
+{
+  measure(batch);
+
+  // keep the order of the survivors, later stages rely on it
+  auto last = std::remove_if(batch.survivors.begin(), batch.survivors.end(),
+                             [this](int c) { return !feasible(c); });
+  batch.survivors.erase(last, batch.survivors.end());
+
+  return batch.survivors.size();
+}
@@ -0,0 +1,61 @@
+#ifndef FEASIBILITY_H
+#define FEASIBILITY_H
+#include <vector>
+#include "candidate.h"
+
+using std::vector;
+
+/*
+ * Kinematic feasibility check of a candidate batch.
+ *
+ * The simulator follows every point exactly, so the acceleration and jerk
+ * of the car come straight from finite differences of the path. For every
+ * candidate we compute the peak tangential and normal acceleration and the
+ * peak jerk over one 0.02 s step, and the total acceleration and jerk
+ * averaged over a 1 second window as the README describes.
+ */
+class FeasibilityChecker
+{
+public:
+  double dt;            // time between two path points [s]
+  double window;        // averaging window [s]
+  double max_acc;       // limit of the total acceleration [m/s^2]
+  double max_jerk;      // limit of the averaged jerk [m/s^3]
+  double max_step_jerk; // limit of the jerk over a single step [m/s^3]
+  double w_acc;         // weight of the share of the acceleration limit used
+  double w_jerk;        // weight of the share of the jerk limits used
+
+  // metrics of the last checked batch, one entry per candidate
+  vector<double> peak_acc;
+  vector<double> peak_acc_t;
+  vector<double> peak_acc_n;
+  vector<double> peak_jerk;
+  vector<double> avg_acc;
+  vector<double> avg_jerk;
+
+  /*
+   * Constructor
+   */
+  FeasibilityChecker(double max_acc=10., double max_jerk=10., double max_step_jerk=50.,
+                     double dt=0.02, double window=1.0);
+
+  // compute the metrics of every surviving candidate of the batch
+  void measure(const CandidateBatch &batch);
+
+  // measure the survivors and drop the infeasible ones, returns how many are left
+  int filter(CandidateBatch &batch);
+
+  // check the metrics of candidate c against the limits
+  bool feasible(int c) const;
+
+  // cost of how close candidate c gets to the limits, never negative
+  double margin_cost(int c) const;
+
+private:
+  // scratch buffers of velocity and acceleration, reused by every candidate
+  vector<double> vx_, vy_, ax_, ay_;
+
+  void measure_one(const double *x, const double *y, int n, int c);
+};
+
+#endif
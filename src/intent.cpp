@@ -0,0 +1,46 @@
+#include <math.h>
+#include "intent.h"
+
+/*
+ * Initialize CutInDetector
+ */
+
+CutInDetector::CutInDetector(double lane_width, double v_mid, double v_gain,
+                             double t_mid, double t_gain, int min_samples)
+{
+  this->lane_width = lane_width;
+  this->v_mid = v_mid;
+  this->v_gain = v_gain;
+  this->t_mid = t_mid;
+  this->t_gain = t_gain;
+  this->min_samples = min_samples;
+}
+
+
+double CutInDetector::probability(const Track &tr, int ego_lane) const
+{
+  if(tr.d_fit.n < min_samples)
+    return 0.;
+
+  // only the lanes right next to ours can cut in
+  double d = tr.d();
+  int lane = (int)floor(d / lane_width);
+  int side = lane - ego_lane;
+  if(side != 1 && side != -1)
+    return 0.;
+
+  // lateral speed towards our lane, averaged from the trend of d and the measured vd
+  double v_lat = 0.5 * (tr.d_fit.slope() + tr.vd_fit.mean());
+  double v_toward = -side * v_lat;
+  if(v_toward <= 0.)
+    return 0.;
+
+  // distance to the boundary of our lane and the time to get there
+  double boundary = (side > 0) ? (ego_lane + 1) * lane_width : ego_lane * lane_width;
+  double t_cross = fabs(d - boundary) / v_toward;
+
+  double p_speed = 1. / (1. + exp(-v_gain * (v_toward - v_mid)));
+  double p_time = 1. / (1. + exp(-t_gain * (t_mid - t_cross)));
+
+  return p_speed * p_time;
+}
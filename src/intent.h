@@ -0,0 +1,34 @@
+#ifndef INTENT_H
+#define INTENT_H
+#include "tracker.h"
+
+/*
+ * Estimates how likely a tracked car is to cut into our lane.
+ *
+ * The lateral velocity of the car comes from the sliding line fits of its
+ * history: the slope of d and the mean of the measured vd. A car in a lane
+ * next to ours which moves towards it fast enough to cross the lane
+ * boundary soon gets a high probability, long before its d reaches our
+ * lane. Everything reads running sums, so it is O(1) per car and frame.
+ */
+class CutInDetector
+{
+public:
+  double lane_width;
+  double v_mid;    // lateral speed towards our lane at which p is 0.5 [m/s]
+  double v_gain;   // steepness of the speed part [s/m]
+  double t_mid;    // time to reach the lane boundary at which p is 0.5 [s]
+  double t_gain;   // steepness of the time part [1/s]
+  int min_samples; // history needed before guessing anything
+
+  /*
+   * Constructor
+   */
+  CutInDetector(double lane_width=4., double v_mid=0.4, double v_gain=8.,
+                double t_mid=1.5, double t_gain=3., int min_samples=8);
+
+  // probability that the car of track tr enters lane ego_lane soon
+  double probability(const Track &tr, int ego_lane) const;
+};
+
+#endif
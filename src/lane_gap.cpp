@@ -0,0 +1,82 @@
+#include <math.h>
+#include "lane_gap.h"
+
+/*
+ * Initialize LaneGapIndex
+ */
+
+LaneGapIndex::LaneGapIndex(double max_s, int num_lanes, double lane_width, double no_gap)
+{
+  this->max_s = max_s;
+  this->lane_width = lane_width;
+  this->no_gap = no_gap;
+  this->ego_s_ = 0.;
+  this->ego_v_ = 0.;
+  gaps_.resize(num_lanes);
+  reset(0., 0.);
+}
+
+
+void LaneGapIndex::reset(double ego_s, double ego_v)
+{
+  ego_s_ = ego_s;
+  ego_v_ = ego_v;
+  for(auto &g : gaps_)
+  {
+    g.count = 0;
+    g.front_id = -1;
+    g.back_id = -1;
+    g.front_dist = no_gap;
+    g.back_dist = no_gap;
+    g.front_speed = 0.;
+    g.back_speed = 0.;
+    g.front_ttc = INFINITY;
+    g.back_ttc = INFINITY;
+  }
+}
+
+
+void LaneGapIndex::add(int id, double s, double d, double v)
+{
+  int ln = (int)floor(d / lane_width);
+  if(ln < 0 || ln >= (int)gaps_.size())
+    return;
+
+  gaps_[ln].count++;
+  update_gap(gaps_[ln], id, s, v);
+}
+
+
+void LaneGapIndex::add_cut_in(int id, double s, int ln, double v)
+{
+  if(ln < 0 || ln >= (int)gaps_.size())
+    return;
+
+  update_gap(gaps_[ln], id, s, v);
+}
+
+
+void LaneGapIndex::update_gap(LaneGap &g, int id, double s, double v) const
+{
+  // take the short way around the track
+  double dist = fmod(s - ego_s_, max_s);
+  if(dist >= 0.5 * max_s)
+    dist -= max_s;
+  else if(dist < -0.5 * max_s)
+    dist += max_s;
+
+  if(dist >= 0 && dist < g.front_dist)
+  {
+    g.front_id = id;
+    g.front_dist = dist;
+    g.front_speed = v;
+    g.front_ttc = (ego_v_ > v) ? dist / (ego_v_ - v) : INFINITY;
+  }
+  else if(dist < 0 && -dist < g.back_dist)
+  {
+    g.back_id = id;
+    g.back_dist = -dist;
+    g.back_speed = v;
+    g.back_ttc = (v > ego_v_) ? -dist / (v - ego_v_) : INFINITY;
+  }
+}
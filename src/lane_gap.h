@@ -0,0 +1,65 @@
+#ifndef LANE_GAP_H
+#define LANE_GAP_H
+#include <vector>
+
+using std::vector;
+
+/*
+ * Nearest cars ahead of and behind the ego car in one lane.
+ */
+struct LaneGap
+{
+  int count;          // number of cars in the lane
+  int front_id;       // id of the nearest car ahead, -1 if none
+  int back_id;        // id of the nearest car behind, -1 if none
+  double front_dist;  // gap to the nearest car ahead [m]
+  double back_dist;   // gap to the nearest car behind [m]
+  double front_speed; // speed of the nearest car ahead [m/s]
+  double back_speed;  // speed of the nearest car behind [m/s]
+  double front_ttc;   // time until we reach the car ahead [s]
+  double back_ttc;    // time until the car behind reaches us [s]
+};
+
+/*
+ * Gap summary of every lane, built in one pass over sensor fusion.
+ *
+ * Every behavior query reads the precomputed gaps of a lane instead of
+ * scanning the traffic again. Distances are taken the short way around
+ * the track, so cars just across max_s are seen correctly.
+ */
+class LaneGapIndex
+{
+public:
+  double max_s;       // length of the track before s wraps around
+  double no_gap;      // distance reported when there is no car
+  double lane_width;
+
+  /*
+   * Constructor
+   */
+  LaneGapIndex(double max_s, int num_lanes=3, double lane_width=4., double no_gap=9999.);
+
+  // forget all cars, gaps are measured from ego_s for an ego car driving at ego_v [m/s]
+  void reset(double ego_s, double ego_v);
+
+  // account for a car at (s, d) driving at v [m/s]
+  void add(int id, double s, double d, double v);
+
+  // a car about to enter lane ln limits its gaps, but isn't counted as a car of it
+  void add_cut_in(int id, double s, int ln, double v);
+
+  // get the gaps of lane ln
+  const LaneGap &lane(int ln) const { return gaps_[ln]; }
+
+  int num_lanes() const { return (int)gaps_.size(); }
+
+private:
+  double ego_s_;
+  double ego_v_;
+  vector<LaneGap> gaps_;
+
+  // take a car at s driving at v as the nearest one of g if it is
+  void update_gap(LaneGap &g, int id, double s, double v) const;
+};
+
+#endif
@@ -0,0 +1,136 @@
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <math.h>
+#include "lane_topology.h"
+
+using std::ifstream;
+using std::istringstream;
+
+/*
+ * Initialize LaneTopology
+ */
+
+LaneTopology::LaneTopology(double max_s, int num_lanes, double lane_width)
+{
+  this->max_s = max_s;
+  this->lane_width = lane_width;
+  this->max_lanes_ = num_lanes;
+  range_s_.push_back(0.);
+  range_lanes_.push_back(num_lanes);
+}
+
+
+bool LaneTopology::load(const string &file)
+{
+  ifstream in(file.c_str(), ifstream::in);
+  if(!in.is_open())
+    return false;
+
+  vector<double> old_s;
+  vector<int> old_lanes;
+  old_s.swap(range_s_);
+  old_lanes.swap(range_lanes_);
+  int old_max = max_lanes_;
+  max_lanes_ = 0;
+
+  string line;
+  while(getline(in, line))
+  {
+    istringstream iss(line);
+    double s;
+    int n;
+    if(iss >> s >> n && n > 0)
+      add_range(s, n);
+  }
+
+  // a file without any range leaves the topology as it was
+  if(range_s_.empty())
+  {
+    range_s_.swap(old_s);
+    range_lanes_.swap(old_lanes);
+    max_lanes_ = old_max;
+    return false;
+  }
+
+  return true;
+}
+
+
+void LaneTopology::add_range(double s_start, int num_lanes)
+{
+  s_start = fmod(s_start, max_s);
+  if(s_start < 0)
+    s_start += max_s;
+  auto it = std::upper_bound(range_s_.begin(), range_s_.end(), s_start);
+  int i = it - range_s_.begin();
+  if(i > 0 && range_s_[i - 1] == s_start)
+  {
+    range_lanes_[i - 1] = num_lanes;
+  }
+  else
+  {
+    range_s_.insert(it, s_start);
+    range_lanes_.insert(range_lanes_.begin() + i, num_lanes);
+  }
+
+  max_lanes_ = *std::max_element(range_lanes_.begin(), range_lanes_.end());
+}
+
+
+int LaneTopology::range_at(double s) const
+{
+  s = fmod(s, max_s);
+  if(s < 0)
+    s += max_s;
+  int i = std::upper_bound(range_s_.begin(), range_s_.end(), s) - range_s_.begin() - 1;
+
+  // before the first start we are still in the last range, which wraps past max_s
+  return i >= 0 ? i : (int)range_s_.size() - 1;
+}
+
+
+int LaneTopology::num_lanes_at(double s) const
+{
+  return range_lanes_[range_at(s)];
+}
+
+
+int LaneTopology::min_lanes(double s_lo, double s_hi) const
+{
+  int n = num_lanes_at(s_lo);
+  // walk the range boundaries inside (s_lo, s_hi], a few at most
+  int i = range_at(s_lo);
+  double s = s_lo;
+  while(true)
+  {
+    int next = (i + 1) % (int)range_s_.size();
+    double ds = fmod(range_s_[next] - fmod(s, max_s) + max_s, max_s);
+    if(next == i || ds <= 0 || s + ds > s_hi)
+      break;
+    s += ds;
+    i = next;
+    n = std::min(n, range_lanes_[i]);
+  }
+
+  return n;
+}
+
+
+int LaneTopology::lane_of(double d) const
+{
+  int ln = (int)floor(d / lane_width);
+  return ln < 0 ? 0 : (ln >= max_lanes_ ? max_lanes_ - 1 : ln);
+}
+
+
+void LaneTopology::assign(const double *d, int *lanes, int n) const
+{
+  const double inv_width = 1. / lane_width;
+  const int top = max_lanes_ - 1;
+  for(int i = 0; i < n; ++i)
+  {
+    int ln = (int)floor(d[i] * inv_width);
+    lanes[i] = ln < 0 ? 0 : (ln > top ? top : ln);
+  }
+}
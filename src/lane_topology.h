@@ -0,0 +1,63 @@
+#ifndef LANE_TOPOLOGY_H
+#define LANE_TOPOLOGY_H
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+/*
+ * Lanes of the highway.
+ *
+ * Lanes are numbered from the center line outwards, lane ln covering
+ * d in [ln * lane_width, (ln + 1) * lane_width), so finding the lane of a
+ * car is a single floor-divide. The number of lanes may change along the
+ * track, every range starts at some s and lasts until the next one; the
+ * last range wraps past max_s up to the start of the first one.
+ */
+class LaneTopology
+{
+public:
+  double lane_width;
+  double max_s;     // length of the track before s wraps around
+
+  /*
+   * Constructor
+   */
+  LaneTopology(double max_s, int num_lanes=3, double lane_width=4.);
+
+  // read the lane count ranges, one "s num_lanes" pair per line. Returns
+  // false and keeps the current ranges if the file can't be read.
+  bool load(const string &file);
+
+  // set the lane count from s_start up to the next range
+  void add_range(double s_start, int num_lanes);
+
+  // number of lanes at s
+  int num_lanes_at(double s) const;
+
+  // smallest number of lanes between s_lo and s_hi
+  int min_lanes(double s_lo, double s_hi) const;
+
+  // largest number of lanes anywhere on the track, to size per-lane arrays
+  int max_lanes() const { return max_lanes_; }
+
+  // lane at distance d from the center line, clamped to the road
+  int lane_of(double d) const;
+
+  // lane of every car in one pass, lanes[i] = lane_of(d[i])
+  void assign(const double *d, int *lanes, int n) const;
+
+  // d of the center of lane ln
+  double center(int ln) const { return (ln + 0.5) * lane_width; }
+
+private:
+  vector<double> range_s_;  // start of every range, sorted
+  vector<int> range_lanes_;
+  int max_lanes_;
+
+  // index of the range which contains s
+  int range_at(double s) const;
+};
+
+#endif
@@ -0,0 +1,61 @@
+#include <algorithm>
+#include <math.h>
+#include "latency.h"
+
+/*
+ * Initialize LatencyMonitor
+ */
+
+LatencyMonitor::LatencyMonitor(double point_dt, double alpha, double max_latency)
+{
+  this->point_dt = point_dt;
+  this->alpha = alpha;
+  this->max_latency = max_latency;
+  this->sent_ = false;
+  this->sent_points_ = 0;
+  this->send_time_ = 0.;
+  this->receive_time_ = 0.;
+  this->planning_time_ = 0.;
+  this->transport_time_ = 0.;
+  this->consumed_ = 0;
+  this->latency_ = 0.;
+}
+
+
+void LatencyMonitor::on_receive(double now, int prev_size)
+{
+  receive_time_ = now;
+  if(!sent_)
+    return;
+
+  // The path reached the simulator `down` after we sent it and the telemetry
+  // left the simulator `up` before it got here, in between the simulator drove
+  // (consumed * point_dt) seconds of our path:
+  //   driven = waited - (down + up)
+  // so the transport time is what we waited beyond the driven time. Together
+  // with the planning time of the next frame, the latency on_send() measures
+  // is the time between two sends minus the driven time.
+  consumed_ = std::max(sent_points_ - prev_size, 0);
+  double driven = consumed_ * point_dt;
+  double waited = now - send_time_;
+  transport_time_ = std::max(waited - driven, 0.);
+}
+
+
+void LatencyMonitor::on_send(double now, int n_points)
+{
+  planning_time_ = now - receive_time_;
+
+  double measured = std::min(planning_time_ + transport_time_, max_latency);
+  latency_ = sent_ ? (1. - alpha) * latency_ + alpha * measured : measured;
+
+  sent_ = true;
+  sent_points_ = n_points;
+  send_time_ = now;
+}
+
+
+int LatencyMonitor::lag_points() const
+{
+  return (int)lround(latency_ / point_dt);
+}
@@ -0,0 +1,56 @@
+#ifndef LATENCY_H
+#define LATENCY_H
+
+/*
+ * Measures how late our plans reach the simulator.
+ *
+ * The simulator keeps driving along the last path while we plan, so when
+ * a new path arrives the car is already a few points further. Two things
+ * make up that delay: the wall-clock time from receiving telemetry to
+ * sending the path, and the transport time. The transport part is seen
+ * in the points the simulator consumed between our last send and the
+ * next telemetry: the simulator only drives our path once it arrived and
+ * until it sends telemetry, so the wall-clock time in between which was
+ * not driven went to transport.
+ */
+class LatencyMonitor
+{
+public:
+  double point_dt;     // time between two path points [s]
+  double alpha;        // weight of a new measurement in the smoothed latency
+  double max_latency;  // a single frame can't push the estimate beyond this [s]
+
+  /*
+   * Constructor
+   */
+  LatencyMonitor(double point_dt=0.02, double alpha=0.2, double max_latency=0.2);
+
+  // telemetry arrived at wall time now [s], prev_size points of our last path are left
+  void on_receive(double now, int prev_size);
+
+  // a path of n_points points was sent at wall time now [s]
+  void on_send(double now, int n_points);
+
+  // smoothed end-to-end latency [s]
+  double latency() const { return latency_; }
+
+  // how many path points the simulator drives during the latency
+  int lag_points() const;
+
+  // measurements of the last frame
+  double planning_time() const { return planning_time_; }
+  double transport_time() const { return transport_time_; }
+  int points_consumed() const { return consumed_; }
+
+private:
+  bool sent_;
+  int sent_points_;
+  double send_time_;
+  double receive_time_;
+  double planning_time_;
+  double transport_time_;
+  int consumed_;
+  double latency_;
+};
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef LINE_FIT_H
+#define LINE_FIT_H
+
+/*
+ * Least-squares line y = a + b * t over a sliding window of samples.
+ * Keeps only the running sums, so adding or removing a sample is O(1).
+ * Use times relative to some start to keep the sums well conditioned.
+ */
+struct LineFit
+{
+  int n;
+  double st, sy, stt, sty;
+
+  void clear() { n = 0; st = sy = stt = sty = 0.; }
+
+  void add(double t, double y)
+  {
+    n++;
+    st += t;
+    sy += y;
+    stt += t * t;
+    sty += t * y;
+  }
+
+  void remove(double t, double y)
+  {
+    n--;
+    st -= t;
+    sy -= y;
+    stt -= t * t;
+    sty -= t * y;
+  }
+
+  // slope b, 0 until there are two distinct times
+  double slope() const
+  {
+    double den = n * stt - st * st;
+    return (n > 1 && den > 1e-12) ? (n * sty - st * sy) / den : 0.;
+  }
+
+  // mean of the samples
+  double mean() const { return n > 0 ? sy / n : 0.; }
+
+  // fitted y at time t
+  double at(double t) const { return n > 0 ? mean() + slope() * (t - st / n) : 0.; }
+};
+
+#endif
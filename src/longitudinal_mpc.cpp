@@ -0,0 +1,172 @@
+#include <algorithm>
+#include <math.h>
+#include "longitudinal_mpc.h"
+
+/*
+ * Initialize LongitudinalMpc
+ */
+
+LongitudinalMpc::LongitudinalMpc(double dt, double min_acc, double max_acc, double max_jerk,
+                                 double v_max, double w_gap, double w_speed,
+                                 double w_acc, double w_jerk, int max_iter)
+{
+  this->dt = dt;
+  this->min_acc = min_acc;
+  this->max_acc = max_acc;
+  this->max_jerk = max_jerk;
+  this->v_max = v_max;
+  this->headway = 1.0;
+  this->min_gap = 8.;
+  this->rho = 1.;
+  this->sigma = 1e-6;
+  this->tol = 1e-3;
+  this->max_iter = max_iter;
+  w_gap_ = w_gap;
+  w_speed_ = w_speed;
+  w_acc_ = w_acc;
+  w_jerk_ = w_jerk;
+
+  // column j: the states after a unit jerk during step j
+  Gs_.setZero();
+  Gv_.setZero();
+  Ga_.setZero();
+  for(int j = 0; j < N; ++j)
+  {
+    double s = 0., v = 0., a = 0.;
+    for(int k = 0; k < N; ++k)
+    {
+      double u = (k == j) ? 1. : 0.;
+      s += v * dt + 0.5 * a * dt * dt + u * dt * dt * dt / 6.;
+      v += a * dt + 0.5 * u * dt * dt;
+      a += u * dt;
+      Gs_(k, j) = s;
+      Gv_(k, j) = v;
+      Ga_(k, j) = a;
+    }
+  }
+
+  C_.block<N, N>(0, 0) = MatN::Identity();
+  C_.block<N, N>(N, 0) = Ga_;
+  C_.block<N, N>(2 * N, 0) = Gv_;
+
+  MatN H = w_speed_ * Gv_.transpose() * Gv_ + w_acc_ * Ga_.transpose() * Ga_ +
+           w_jerk_ * MatN::Identity();
+  MatN Ge = Gs_ + headway * Gv_;
+  MatN K = H + sigma * MatN::Identity() + rho * C_.transpose() * C_;
+  llt_[0].compute(K);
+  llt_[1].compute(K + w_gap_ * Ge.transpose() * Ge);
+
+  u_.setZero();
+  z_.setZero();
+  y_.setZero();
+  iterations_ = 0;
+  v0_ = 0.;
+  a0_ = 0.;
+  std::fill(v_, v_ + N + 1, 0.);
+  std::fill(a_, a_ + N + 1, 0.);
+}
+
+
+int LongitudinalMpc::solve(double v0, double a0, const double *v_ref,
+                           bool has_lead, double lead_gap, double lead_v)
+{
+  v0_ = v0;
+  a0_ = a0;
+
+  // states without any jerk
+  VecN free_s, free_v, free_a;
+  double s = 0., v = v0, a = a0;
+  for(int k = 0; k < N; ++k)
+  {
+    s += v * dt + 0.5 * a * dt * dt;
+    v += a * dt;
+    free_s(k) = s;
+    free_v(k) = v;
+    free_a(k) = a;
+  }
+
+  // linear part of the cost, the quadratic part is in the factors
+  VecN r_v;
+  for(int k = 0; k < N; ++k)
+    r_v(k) = v_ref[k] - free_v(k);
+  VecN q = -w_speed_ * Gv_.transpose() * r_v + w_acc_ * Ga_.transpose() * free_a;
+  if(has_lead)
+  {
+    VecN r_gap;
+    for(int k = 0; k < N; ++k)
+      r_gap(k) = lead_gap + lead_v * (k + 1) * dt - min_gap - free_s(k) - headway * free_v(k);
+    q -= w_gap_ * (Gs_ + headway * Gv_).transpose() * r_gap;
+  }
+  const Eigen::LLT<MatN> &llt = llt_[has_lead ? 1 : 0];
+
+  VecM lo, hi;
+  for(int k = 0; k < N; ++k)
+  {
+    lo(k) = -max_jerk;
+    hi(k) = max_jerk;
+    lo(N + k) = min_acc - free_a(k);
+    hi(N + k) = max_acc - free_a(k);
+    lo(2 * N + k) = -free_v(k);
+    hi(2 * N + k) = v_max - free_v(k);
+  }
+
+  // warm start from the last solution, one step later
+  for(int k = 0; k < N - 1; ++k)
+  {
+    u_(k) = u_(k + 1);
+    for(int b = 0; b < 3; ++b)
+    {
+      z_(b * N + k) = z_(b * N + k + 1);
+      y_(b * N + k) = y_(b * N + k + 1);
+    }
+  }
+
+  int it = 0;
+  for(; it < max_iter; ++it)
+  {
+    VecN rhs = sigma * u_ - q + C_.transpose() * (rho * z_ - y_);
+    u_ = llt.solve(rhs);
+    VecM Cu = C_ * u_;
+    VecM z_old = z_;
+    z_ = (Cu + y_ / rho).cwiseMax(lo).cwiseMin(hi);
+    y_ += rho * (Cu - z_);
+
+    double primal = (Cu - z_).lpNorm<Eigen::Infinity>();
+    double dual = rho * (C_.transpose() * (z_ - z_old)).lpNorm<Eigen::Infinity>();
+    if(primal < tol && dual < tol)
+    {
+      ++it;
+      break;
+    }
+  }
+  iterations_ = it;
+
+  // roll out the jerks, clamped into the boxes the last iterate may miss
+  v_[0] = v0;
+  a_[0] = a0;
+  for(int k = 0; k < N; ++k)
+  {
+    double u = std::min(std::max(u_(k), -max_jerk), max_jerk);
+    double a_next = std::min(std::max(a_[k] + u * dt, min_acc), max_acc);
+    v_[k + 1] = std::max(v_[k] + 0.5 * (a_[k] + a_next) * dt, 0.);
+    a_[k + 1] = a_next;
+  }
+
+  return iterations_;
+}
+
+
+double LongitudinalMpc::speed_at(double t) const
+{
+  double x = std::min(std::max(t / dt, 0.), (double)N);
+  int k = std::min((int)x, N - 1);
+  return v_[k] + (x - k) * (v_[k + 1] - v_[k]);
+}
+
+
+double LongitudinalMpc::accel_at(double t) const
+{
+  double x = std::min(std::max(t / dt, 0.), (double)N);
+  int k = std::min((int)x, N - 1);
+  return a_[k] + (x - k) * (a_[k + 1] - a_[k]);
+}
@@ -0,0 +1,87 @@
+#ifndef LONGITUDINAL_MPC_H
+#define LONGITUDINAL_MPC_H
+#include "Eigen-3.3/Eigen/Core"
+#include "Eigen-3.3/Eigen/Cholesky"
+
+/*
+ * Linear MPC of the ego speed along the road.
+ *
+ * The ego is a triple integrator (s, v, a) driven by the jerk, which is
+ * held constant over each of the N steps. The cost tracks a reference
+ * speed and, behind a lead car, the time gap to it, and keeps the
+ * acceleration and jerk small. The jerk, the acceleration and the speed
+ * are boxed.
+ *
+ * The condensed QP over the N jerks is solved with ADMM. Its matrix only
+ * depends on the weights and on whether there is a lead car, so both
+ * Cholesky factors are computed once at construction and every iteration
+ * is a pair of triangular solves and a clamp. All types are fixed-size,
+ * nothing is allocated while solving. The iterations start from the
+ * solution of the last frame shifted by one step and are capped at
+ * max_iter.
+ */
+class LongitudinalMpc
+{
+public:
+  static const int N = 15;       // steps of the horizon
+  static const int M = 3 * N;    // constraint rows: jerk, acceleration, speed
+
+  typedef Eigen::Matrix<double, N, 1> VecN;
+  typedef Eigen::Matrix<double, M, 1> VecM;
+  typedef Eigen::Matrix<double, N, N> MatN;
+  typedef Eigen::Matrix<double, M, N> MatMN;
+
+  double dt;        // time of one step [s]
+  double min_acc;   // [m/s^2]
+  double max_acc;   // [m/s^2]
+  double max_jerk;  // [m/s^3]
+  double v_max;     // [m/s]
+  double headway;   // time gap to keep to the lead car [s]
+  double min_gap;   // distance to keep to the lead car when standing [m]
+  double rho;       // ADMM penalty
+  double sigma;     // ADMM regularization
+  double tol;       // residual at which the iterations stop early
+  int max_iter;
+
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+  /*
+   * Constructor
+   */
+  LongitudinalMpc(double dt=0.2, double min_acc=-7., double max_acc=5., double max_jerk=9.,
+                  double v_max=49.5 / 2.24, double w_gap=0.5, double w_speed=1.,
+                  double w_acc=0.5, double w_jerk=0.2, int max_iter=40);
+
+  /*
+   * Solve from speed v0 and acceleration a0. v_ref holds the reference
+   * speed at the end of each step. With a lead car, lead_gap is its
+   * distance now and lead_v its speed, which it keeps.
+   * Returns the iterations used.
+   */
+  int solve(double v0, double a0, const double *v_ref,
+            bool has_lead=false, double lead_gap=0., double lead_v=0.);
+
+  // planned speed and acceleration at time t
+  double speed_at(double t) const;
+  double accel_at(double t) const;
+
+  int iterations() const { return iterations_; }
+
+private:
+  double w_gap_, w_speed_, w_acc_, w_jerk_;
+
+  // response of s, v and a at the end of every step to the jerks
+  MatN Gs_, Gv_, Ga_;
+  MatMN C_;
+  Eigen::LLT<MatN> llt_[2];  // without and with a lead car
+
+  // warm start
+  VecN u_;
+  VecM z_, y_;
+
+  int iterations_;
+  double v0_, a0_;
+  double v_[N + 1], a_[N + 1];
+};
+
+#endif
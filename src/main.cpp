@@ -1,4 +1,5 @@
 #include <fstream>
+#include <sstream>
 #include <math.h>
 #include <uWS/uWS.h>
 #include <chrono>
@@ -12,6 +13,33 @@
 #include "json.hpp"
 #include "spline.h"
 #include "vehicle.h"
+#include "occupancy.h"
+#include "obb_collision.h"
+#include "candidate.h"
+#include "feasibility.h"
+#include "cost.h"
+#include "lane_gap.h"
+#include "traffic.h"
+#include "lane_topology.h"
+#include "tracker.h"
+#include "prediction.h"
+#include "latency.h"
+#include "intent.h"
+#include "mlp_predictor.h"
+#include "worker_pool.h"
+#include "particle_predictor.h"
+#include "maneuver_search.h"
+#include "deadline.h"
+#include "speed_planner.h"
+#include "motion_primitive.h"
+#include "longitudinal_mpc.h"
+#include "s_curve.h"
+#include "reference_line.h"
+#include "emitted_path.h"
+#include "steady_cruise.h"
+#include "planning_horizon.h"
+#include "double_buffer.h"
+#include "behavior_layer.h"
 
 using namespace std;
 
@@ -167,7 +195,74 @@ vector<double> getXY(double s, double d, const vector<double> &maps_s, const vec
 
 }
 
-int main() {
+// Sample a lane change from the ego position to target_d every dt seconds.
+// The ego keeps its speed and moves to target_d along the quickest feasible
+// primitive of the library, or in about 2 seconds if there is none.
+int lane_change_steps(const MotionPrimitiveLibrary &prims, const Vehicle &ego, double target_d,
+                      double dt, int n_steps, double *ego_s, double *ego_d)
+{
+  n_steps = min(n_steps, 64);
+  double ego_v = ego.v / 2.24;  // mph to meter per seconds
+  double horizon = 2.0;
+  const MotionPrimitive *prim = prims.shortest(ego_v, ego_v, target_d - ego.d, &horizon);
+  // the primitive is on the grid of offsets, only its shape is used
+  double full = prim ? prim->d(horizon) : 0.;
+  for(int t = 0; t < n_steps; ++t)
+  {
+    double time = t * dt;
+    double shape = min(time / 2.0, 1.0);
+    if(fabs(full) > 1e-3)
+      shape = time < horizon ? prim->d(time) / full : 1.0;
+    ego_s[t] = ego.s + ego_v * time;
+    ego_d[t] = ego.d + (target_d - ego.d) * shape;
+  }
+
+  return n_steps;
+}
+
+// Check a lane change to target_d against the predicted cars.
+bool lane_change_collides(const FrenetOccupancy &occupancy, const MotionPrimitiveLibrary &prims,
+                          const Vehicle &ego, double target_d)
+{
+  double ego_s[64];
+  double ego_d[64];
+  int n_steps = lane_change_steps(prims, ego, target_d, occupancy.dt, occupancy.num_steps,
+                                  ego_s, ego_d);
+
+  return occupancy.first_collision(ego_s, ego_d, n_steps) >= 0;
+}
+
+// Chance that a lane change to target_d runs into one of the sampled futures of the cars.
+double lane_change_risk(const ParticlePredictor &particles, const MotionPrimitiveLibrary &prims,
+                        const Vehicle &ego, double target_d)
+{
+  double ego_s[64];
+  double ego_d[64];
+  int n_steps = lane_change_steps(prims, ego, target_d, particles.dt, particles.num_steps,
+                                  ego_s, ego_d);
+
+  return particles.path_risk(ego_s, ego_d, n_steps);
+}
+
+// Cost of the behavior states, a gap ahead matters more when we keep lane
+typedef CostEngine<Weighted<KeepLaneGapCost>,
+                   Weighted<ChangeLaneGapCost>,
+                   Weighted<ChangeLaneDurationCost>> BehaviorCost;
+
+// Split a velocity (vx, vy) at s into its parts along (vs) and across (vd) the road
+void getFrenetVelocity(double s, double vx, double vy, const vector<double> &maps_s,
+                       const vector<double> &maps_dx, const vector<double> &maps_dy,
+                       double &vs, double &vd)
+{
+	int wp = std::upper_bound(maps_s.begin(), maps_s.end(), s) - maps_s.begin() - 1;
+	wp = max(wp, 0);
+
+	// (dx, dy) points to the right of the road, the road heads along (-dy, dx)
+	vd = vx*maps_dx[wp] + vy*maps_dy[wp];
+	vs = -vx*maps_dy[wp] + vy*maps_dx[wp];
+}
+
+int main(int argc, char **argv) {
   uWS::Hub h;
 
   // Load up map values for waypoint's x,y,s and d normalized normal vectors
@@ -204,13 +299,194 @@ int main() {
   	map_waypoints_dy.push_back(d_y);
   }
 
+  // Number of lanes along the track, three everywhere if the file is missing
+  LaneTopology lanes(max_s);
+  lanes.load("../data/highway_lanes.csv");
+
   // start in lane 1
   int lane = 1;
 
-  // have a reference volecity to target
-  double ref_vel = 0.;  //mph
+  // occupancy of predicted cars over the next 3 seconds, allocated once
+  FrenetOccupancy occupancy(max_s, lanes.max_lanes(), 30, 0.1, 256, 1.0, lanes.lane_width);
+  // the same cars as oriented boxes in world coordinates
+  ObbCollision obb;
+  // and as larger boxes, a path through them passes a car too close
+  ObbCollision near_miss(obb.num_steps(), obb.dt, 256, obb.point_dt, 5.f, 1.5f);
+  // nearest cars ahead and behind in every lane
+  LaneGapIndex lane_gaps(max_s, lanes.max_lanes(), lanes.lane_width);
+  // cars around us, rebuilt in place every frame
+  TrafficSnapshot traffic(lanes);
+  // cars followed across frames by their sensor fusion ID
+  Tracker tracker(max_s);
+  // where the cars go over the next 3 seconds
+  Prediction prediction;
+  prediction.max_d = lanes.max_lanes() * lanes.lane_width;
+  // learned correction of the prediction, only used when its weights are there;
+  // none ship with the project, so by default the prediction stays kinematic
+  MlpPredictor mlp(256, lanes.lane_width);
+  if(mlp.load("../data/mlp_predictor.bin"))
+    cout << "refine the prediction with ../data/mlp_predictor.bin (" << mlp.kernel() << ")\n";
+  else
+    cout << "no ../data/mlp_predictor.bin, the learned prediction is off\n";
+  // threads for the data-parallel stages
+  WorkerPool pool;
+  // sampled futures of the cars, how likely a cell is taken
+  ParticlePredictor particles(max_s, &pool, 256, 64, occupancy.num_steps, occupancy.dt,
+                              lanes.max_lanes(), lanes.lane_width);
+  // sequences of maneuvers a few steps ahead
+  ManeuverSearch lookahead(max_s, &pool, 4, 8, 1.5, lanes.lane_width);
+  auto start_time = chrono::steady_clock::now();
+  // how late our paths reach the simulator
+  LatencyMonitor latency;
+  // time we give ourselves per frame before the path has to go out
+  Deadline deadline(10.);
+  // speed profile along the chosen lane
+  SpeedPlanner speed_planner(max_s);
+  // smooth tracking of that profile and of the car ahead
+  LongitudinalMpc speed_mpc;
+  // jerk-limited speed changes point by point
+  SCurveTable s_curve;
+  // plan in frenet and convert in bulk along a smooth center line with --frenet,
+  // otherwise fit a spline through three anchors every frame;
+  // decide on the lane --behavior-hz times a second, 10 by default
+  bool frenet_pipeline = false;
+  double behavior_hz = 10.;
+  for(int i = 1; i < argc; ++i)
+  {
+    if(string(argv[i]) == "--frenet")
+      frenet_pipeline = true;
+    else if(string(argv[i]) == "--behavior-hz" && i + 1 < argc)
+      behavior_hz = max(atof(argv[++i]), 1.);
+  }
+  ReferenceLine ref_line(map_waypoints_s, map_waypoints_x, map_waypoints_y, max_s);
+  // the points we sent and the state of the car at each of them
+  EmittedPath emitted;
+  // extends the path without replanning while we cruise alone in our lane
+  SteadyCruise cruise;
+  // path length, anchor spacing and replan period, adapted to speed and traffic
+  PlanningHorizon horizon;
+  if(horizon.load("../data/planning_horizon.cfg"))
+    cout << "planning horizon from ../data/planning_horizon.cfg\n";
+  // lane changes of known feasibility, generated offline by primitive_gen
+  MotionPrimitiveLibrary primitives;
+  if(primitives.open("../data/motion_primitives.bin"))
+    cout << primitives.size() << " motion primitives from ../data/motion_primitives.bin\n";
+  // with --frenet, the lane change the emitted path follows from the library
+  LaneChangePrimitive lane_change;
+  // guesses which cars are about to change into our lane
+  CutInDetector cut_in(lanes.lane_width);
+  // candidate paths of one frame and the stages they go through
+  CandidateBatch candidates;
+  FeasibilityChecker feasibility;
+  StageMetrics metrics;
+  BehaviorCost behavior_cost(Weighted<KeepLaneGapCost>(60.),
+                             Weighted<ChangeLaneGapCost>(30.),
+                             Weighted<ChangeLaneDurationCost>(1.5));
+
+  // The behavior layer picks the lane at its own rate on its own thread, the
+  // trajectory layer extends the path on every message. The world goes to the
+  // behavior and its decisions come back through lock-free double buffers.
+  DoubleBuffer<BehaviorInput> world(BehaviorInput(traffic, lane_gaps, prediction));
+  DoubleBuffer<BehaviorDecision> decisions;
+  LayerMetrics trajectory_metrics;
+  long frame = 0;
+  double world_time = -1.;
+  // only used on the behavior thread
+  Deadline behavior_deadline(50.);
+  LayerMetrics behavior_metrics;
+  PeriodicLayer behavior(behavior_hz);
+  behavior.start([&]()
+  {
+    if(!world.update())
+      return;
+    const BehaviorInput &in = world.front();
+    auto t_start = chrono::steady_clock::now();
+    behavior_deadline.start();
+    Vehicle ego = in.ego;
+
+    // where the cars may go, for the checks of the lane changes
+    occupancy.reset(ego.s);
+    occupancy.add_prediction(in.prediction);
+    particles.predict(in.traffic, ego.s);
+
+    // a lane which ends within our anchors is not available
+    int num_lanes = lanes.min_lanes(ego.s, ego.s + 3 * in.spacing);
+    vector<State> pos_next_states = ego.successor_states(num_lanes);
+    // gather what the cost terms need for every possible next state
+    int n_states = pos_next_states.size();
+    vector<int> next_lanes(n_states);
+    vector<double> front_dists(n_states);
+    vector<double> back_dists(n_states);
+    vector<double> lane_changes(n_states);
+    vector<double> lane_busy(n_states);
+    for(int i = 0; i < n_states; ++i)
+    {
+      State st = pos_next_states[i];
+      int ln = ego.lane + (st == State::LCL ? -1 : (st == State::LCR ? 1 : 0));
+      const LaneGap &gap = in.gaps.lane(ln);
+      next_lanes[i] = ln;
+      front_dists[i] = gap.front_dist;
+      back_dists[i] = gap.back_dist;
+      lane_changes[i] = (st == State::KL) ? 0. : 1.;
+      lane_busy[i] = gap.count > 0 ? 1. : 0.;
+    }
+
+    CostInputs cost_in;
+    cost_in.size = n_states;
+    cost_in.front_dist = front_dists.data();
+    cost_in.back_dist = back_dists.data();
+    cost_in.lane_change = lane_changes.data();
+    cost_in.lane_busy = lane_busy.data();
+    cost_in.keep_duration = in.keep_duration;
+    vector<double> costs(n_states);
+    behavior_cost.evaluate(cost_in, costs.data());
+
+    BehaviorDecision &out = decisions.back();
+
+    // a maneuver which only leads to worse sequences costs the meters it loses
+    auto t_search = chrono::steady_clock::now();
+    lookahead.search(in.prediction, ego.s, ego.lane, ego.v / 2.24, num_lanes, &behavior_deadline);
+    out.search_depth = lookahead.depth_reached();
+    for(int i = 0; i < n_states; ++i)
+      costs[i] += 0.1 * lookahead.regret(pos_next_states[i]);
+    out.search_ms = chrono::duration<double, milli>(chrono::steady_clock::now() - t_search).count();
+
+    ostringstream report;
+    out.lane_cost.assign(lanes.max_lanes(), 1e9);
+    for(int i = 0; i < n_states; ++i)
+    {
+      // panelty to cut into a car predicted in the target lane
+      if(next_lanes[i] != ego.lane &&
+         lane_change_collides(occupancy, primitives, ego, lanes.center(next_lanes[i])))
+        costs[i] += 999.;
+      // and a smaller one for the risk that a car may get there
+      if(next_lanes[i] != ego.lane)
+        costs[i] += 50. * lane_change_risk(particles, primitives, ego, lanes.center(next_lanes[i]));
+      out.lane_cost[next_lanes[i]] = costs[i];
+
+      const char *names[] = {"Keep Lane", "Lane Change Left", "Lane Change Right"};
+      report << names[pos_next_states[i]] << "\ncost: " << costs[i];
+#ifndef NDEBUG
+      report << " (";
+      for(int t = 0; t < BehaviorCost::num_terms; ++t)
+        report << (t ? " + " : "") << behavior_cost.breakdown[t][i];
+      report << ")";
+#endif
+      report << endl;
+    }
 
-  h.onMessage([&ref_vel, &map_waypoints_x,&map_waypoints_y,&map_waypoints_s,&map_waypoints_dx,&map_waypoints_dy, &lane](uWS::WebSocket<uWS::SERVER> ws, char *data, size_t length,
+    // Find the minimum cost state.
+    int best_idx = std::min_element(costs.begin(), costs.end()) - costs.begin();
+    out.lane = next_lanes[best_idx];
+    out.report = report.str();
+    out.frame = in.frame;
+    out.stamp = in.stamp;
+    behavior_metrics.add(chrono::duration<double, milli>(chrono::steady_clock::now() - t_start).count());
+    out.metrics = behavior_metrics;
+    decisions.publish();
+  });
+
+  h.onMessage([&speed_planner, &speed_mpc, &s_curve, &frenet_pipeline, &primitives, &lane_change, &ref_line, &emitted, &cruise, &horizon, &map_waypoints_x,&map_waypoints_y,&map_waypoints_s,&map_waypoints_dx,&map_waypoints_dy, &lane, &obb, &near_miss, &candidates, &feasibility, &metrics, &lane_gaps, &traffic, &lanes, &tracker, &start_time, &prediction, &latency, &cut_in, &mlp, &deadline, &world, &decisions, &behavior, &trajectory_metrics, &frame, &world_time](uWS::WebSocket<uWS::SERVER> ws, char *data, size_t length,
                      uWS::OpCode opCode) {
     // "42" at the start of the message means there's a websocket message event.
     // The 4 signifies a websocket message
@@ -237,22 +513,54 @@ int main() {
           	double car_yaw = j[1]["yaw"];
           	double car_speed = j[1]["speed"];
 
-          	// Previous path data given to the Planner
-          	auto previous_path_x = j[1]["previous_path_x"];
-          	auto previous_path_y = j[1]["previous_path_y"];
-          	// Previous path's end s and d values 
-          	double end_path_s = j[1]["end_path_s"];
-          	double end_path_d = j[1]["end_path_d"];
+          	// Previous path data given to the Planner, we only need how many points
+          	// are left, the points themselves are still in our emitted path
+          	int prev_size = j[1]["previous_path_x"].size();
 
           	// Sensor Fusion Data, a list of all other cars on the same side of the road.
             // a 2D vector of cars state, each row represent one state of car
             // --> [ID, x_map_coor, y_map_coor, x_vel, y_vel, s_fren, d_frent]
           	auto sensor_fusion = j[1]["sensor_fusion"];
 
-            int prev_size = previous_path_x.size();
+            // send a path to the simulator, every frame ends here
+            auto send_path = [&](const vector<double> &next_x_vals, const vector<double> &next_y_vals)
+            {
+              json msgJson;
+              msgJson["next_x"] = next_x_vals;
+              msgJson["next_y"] = next_y_vals;
+
+              auto msg = "42[\"control\","+ msgJson.dump()+"]";
+
+              //this_thread::sleep_for(chrono::milliseconds(1000));
+              latency.on_send(chrono::duration<double>(chrono::steady_clock::now() - start_time).count(),
+                              next_x_vals.size());
+              trajectory_metrics.add(deadline.elapsed_ms());
+              metrics.deadline_missed = !deadline.finish();
+              if(metrics.deadline_missed)
+                cout << "Deadline missed after " << deadline.elapsed_ms() << " ms (" << deadline.misses
+                  << " missed, " << deadline.hits << " in time)\n";
+              ws.send(msg.data(), msg.length(), uWS::OpCode::TEXT);
+            };
+
             // record my own car
             Vehicle ego(211, car_x, car_y, car_s, car_d, car_speed);
+            ego.find_lane(car_d, lanes.lane_width, lanes.max_lanes());
             double max_s = 6945.554;
+
+            // the simulator keeps driving while we plan, measure by how much and
+            // plan from where the car will be when our path arrives
+            deadline.start();
+            double now = chrono::duration<double>(chrono::steady_clock::now() - start_time).count();
+            latency.on_receive(now, prev_size);
+            if(!emitted.sync(prev_size))
+              prev_size = 0;
+            double lag_time = latency.latency();
+            // never drop the previous path points we anchor on
+            int lag = min(latency.lag_points(), max(prev_size - 2, 0));
+            emitted.drop(lag);
+            int n_kept = emitted.size();
+            ego.s = fmod(ego.s + ego.v / 2.24 * lag_time, max_s);
+
             static double keep_duration = 0.01;
             static int ego_lane_pre = 1;
             if (ego_lane_pre == ego.lane)
@@ -265,24 +573,31 @@ int main() {
               keep_duration = 0.01;
             }
 
-            // TODO: Using the data from sensor_fusion to avoid collision
-            if(prev_size > 0)
+            // the new points start in the exact state of the last point we kept
+            double end_d = car_d;
+            double end_v = car_speed / 2.24;
+            double end_a = 0.;
+            double end_vd = 0.;
+            double end_ad = 0.;
+            if(n_kept > 0)
             {
-              car_s = end_path_s;
+              const PathPoint &end = emitted.back();
+              car_s = end.s;
+              end_d = end.d;
+              end_v = end.v;
+              end_a = end.a;
+              end_vd = end.vd;
+              end_ad = end.ad;
             }
 
-            bool too_close = false;
-            vector<vector<Vehicle>> vec_lane {};
-            // only three lanes in this simulation
-            for(int i=0; i<3; ++i)
-              vec_lane.push_back(vector<Vehicle> {});
             std::system("clear");
-            cout << "total lane: " << vec_lane.size() << endl;
+            cout << "total lane: " << traffic.num_lanes << endl;
 
-            // find out the location of all nearby car
+            // record nearby cars, the snapshot culls the ones far away
+            traffic.reset(ego.s);
+            tracker.begin_frame(now, ego.s);
             for (int i = 0; i < (int)sensor_fusion.size(); i++)
             {
-              // record nearby cars
               int n_id = sensor_fusion[i][0];
               double nx = sensor_fusion[i][1];
               double ny = sensor_fusion[i][2];
@@ -291,329 +606,546 @@ int main() {
               double ns = sensor_fusion[i][5];
               double nd = sensor_fusion[i][6];
 
-              // get combination of vx and vy
-              double total_speed = sqrt(nvx*nvx + nvy*nvy);
-              // get current frenet s coord. (have latency)
-              double cur_s = ns; //+ ( (double)prev_size * .02 * total_speed);
-              Vehicle nearCar(n_id, nx, ny, cur_s, nd, total_speed);
-
-              // record nearCar in vec_lane
-              vec_lane[nearCar.lane].push_back(nearCar);
+              // split the velocity along and across the road
+              double nvs, nvd;
+              getFrenetVelocity(ns, nvx, nvy, map_waypoints_s, map_waypoints_dx, map_waypoints_dy,
+                                nvs, nvd);
 
+              // follow the car across frames and take its filtered state
+              const Track *track = tracker.update(n_id, ns, nd, nvs, nvd);
+              double nas = 0.;
+              double nad = 0.;
+              if(track)
+              {
+                ns = track->s();
+                nd = track->d();
+                nvs = track->vs();
+                nvd = track->vd();
+                nas = track->as();
+                nad = track->ad();
+              }
+              // move the car to where it is when our path arrives
+              nx += nvx * lag_time;
+              ny += nvy * lag_time;
+              ns += (nvs + 0.5 * nas * lag_time) * lag_time;
+              nd += nvd * lag_time;
+              traffic.add(n_id, nx, ny, nvx, nvy, ns, nd, nvs, nvd, nas, nad);
             }
+            traffic.finish();
+            tracker.end_frame();
 
-            // check all posible next states
-            cout << "All possible next states are: \n";
-            vector<State> pos_next_states = ego.successor_states();
-            vector<double> costs;
-            double cost;
-            for(auto s : pos_next_states)
+            // find out the location of all nearby car
+            obb.reset();
+            near_miss.reset();
+            bool cutting_in = false;
+            int n_near = 0;
+            lane_gaps.reset(ego.s, ego.v / 2.24);
+            for (int i = 0; i < traffic.size; i++)
             {
-              switch (s) 
+              obb.add_vehicle(traffic.x[i], traffic.y[i], traffic.vx[i], traffic.vy[i]);
+              near_miss.add_vehicle(traffic.x[i], traffic.y[i], traffic.vx[i], traffic.vy[i]);
+              lane_gaps.add(traffic.id[i], traffic.s[i], traffic.d[i], traffic.vs[i]);
+              if(fabs(traffic.rel_s[i]) < horizon.dense_range)
+                n_near++;
+
+              // a car about to cut in already counts for the gaps of our lane
+              const Track *track = tracker.find(traffic.id[i]);
+              double p_cut_in = track ? cut_in.probability(*track, ego.lane) : 0.;
+              if(p_cut_in > 0.5)
               {
-                case State::KL:
-                  {
-                    cout << "Keep Lane\n";
-                    double front_car_dist = 9999.0;
-                    double back_car_dist = 9999.0;
-                    if(vec_lane[ego.lane].size() == 0) // no car at front
-                    {
-                      cost = 0;
-                    }else
-                    {
-                      // find most close car
-                      for(auto car : vec_lane[ego.lane])
-                      { 
-                        double dist = car.s - ego.s;
-                        if( dist >=0 && dist < front_car_dist)
-                        {
-                          front_car_dist = dist;
-                        }else if( dist < 0 && fabs(dist) < back_car_dist)
-                        {
-                          back_car_dist = fabs(dist);
-                        }
-
-                      }
-                      ego.front_dist = front_car_dist;
-                      cost = (60 / front_car_dist);
-
-                    }
-                    cout << "cost: " << cost << endl;
-                    costs.push_back(cost);
-                  }
-                  break;
-                case State::LCL:
-                  {
-                    cout << "Lane Change Left\n";
-                    double front_car_dist = 9999.0;
-                    double back_car_dist = 9999.0;
-                    int ln = ego.lane -1;
-                    if(vec_lane[ln].size() == 0) // no car at front
-                    {
-                      cost = 0;
-                    }else
-                    {
-                      // find most close car
-                      for(auto car : vec_lane[ln])
-                      { 
-                        double dist = car.s - ego.s;
-                        if( dist >=0 && dist < front_car_dist)
-                        {
-                          front_car_dist = dist;
-                        }else if( dist < 0 && fabs(dist) < back_car_dist)
-                        {
-                          back_car_dist = fabs(dist);
-                        }
-
-                      }
-                      ego.left_front_dist = front_car_dist;
-                      cost = (30 / front_car_dist) + (30 / back_car_dist);
-                      // panelty to change lane quickly
-                      //if(keep_duration <= 1.)
-                      cost += (1.5 / keep_duration);
-
-                    }
-                    cout << "cost: " << cost << endl;
-                    costs.push_back(cost);
-                  }
-                  break;
-                case State::LCR:
-                  {
-                    cout << "Lane Change Right\n";
-                    double front_car_dist = 9999.0;
-                    double back_car_dist = 9999.0;
-                    int ln = ego.lane + 1;
-                    if(vec_lane[ln].size() == 0) // no car at front
-                    {
-                      cost = 0;
-                    }else
-                    {
-                      // find most close car
-                      for(auto car : vec_lane[ln])
-                      { 
-                        double dist = car.s - ego.s;
-                        if( dist >=0 && dist < front_car_dist)
-                        {
-                          front_car_dist = dist;
-                        }else if( dist < 0 && fabs(dist) < back_car_dist)
-                        {
-                          back_car_dist = fabs(dist);
-                        }
-
-                      }
-                      ego.right_front_dist = front_car_dist;
-                      cost = (30 / front_car_dist) + (30 / back_car_dist);
-                      // panelty to change lane quickly
-                      //if(keep_duration <= 1.)
-                      cost += (1.5 / keep_duration);
-
-                    }
-                    cout << "cost: " << cost << endl;
-                    costs.push_back(cost);
-                  }
-                  break;
-                default:
-                  cout <<  "Unknown" << ' ';
+                cutting_in = true;
+                cout << "car " << traffic.id[i] << " cuts in (p = " << p_cut_in << ")\n";
+                lane_gaps.add_cut_in(traffic.id[i], traffic.s[i], ego.lane, traffic.vs[i]);
               }
             }
+            obb.prepare();
+            near_miss.prepare();
+
+            // The latest lane decision of the behavior layer. Our own lane is kept
+            // before the first one, and if the decided lane isn't next to us anymore.
+            frame++;
+            metrics.reset();
+            decisions.update();
+            const BehaviorDecision &decision = decisions.front();
+            int cur_lane = ego.lane;
+            // a lane which ends within our anchors is not available
+            int num_lanes = lanes.min_lanes(ego.s, ego.s + 3 * horizon.spacing);
+            int target_lane = cur_lane;
+            if(decision.frame >= 0 && abs(decision.lane - cur_lane) <= 1 && decision.lane < num_lanes)
+              target_lane = decision.lane;
+
+            // predict where every car will be over the next 3 seconds, only for a
+            // replan or when the behavior layer is due for a new world
+            bool predicted = false;
+            auto predict = [&]()
+            {
+              auto t_predict = chrono::steady_clock::now();
+              prediction.predict(traffic);
+              mlp.refine(traffic, tracker, prediction);
+              metrics.prediction_ms = chrono::duration<double, milli>(chrono::steady_clock::now() - t_predict).count();
+              predicted = true;
+            };
+            if(now - world_time >= 1. / behavior.rate_hz)
+            {
+              predict();
+              BehaviorInput &in = world.back();
+              in.frame = frame;
+              in.stamp = now;
+              in.ego = ego;
+              in.keep_duration = keep_duration;
+              in.spacing = horizon.spacing;
+              in.traffic = traffic;
+              in.gaps = lane_gaps;
+              in.prediction = prediction;
+              world.publish();
+              world_time = now;
+            }
 
-            // Find the minimum cost state.
-            vector<double>::iterator best_cost = std::min_element(begin(costs),
-                                                                  end(costs));
-            int best_idx = std::distance(begin(costs), best_cost);
-
-            switch(pos_next_states[best_idx])
+            // Between two replans the points already sent go out as they are, a car
+            // cutting in or a new lane decision is always replanned for
+            horizon.update(ego.v / 2.24, n_near);
+            if(!horizon.replan(n_kept, cutting_in || target_lane != lane))
             {
-              case State::KL:
-                {
-                  if(ego.front_dist < 30)
-                    too_close = true;
-                  ego.state = State::KL;
+              cout << "Path held, " << n_kept << " points left (replan every " << horizon.period
+                << " frames)\n";
+              cruise.hold();
 
-                  lane = ego.lane;
-                }
-                break;
-              case State::LCL:
-                {
-                  if(ego.left_front_dist < 30)
-                    too_close = true;
-                  ego.state = State::LCL;
-                  ego.lane = ego.lane - 1;
+              vector<double> next_x_vals(n_kept);
+              vector<double> next_y_vals(n_kept);
+              for(int i = 0; i < n_kept; ++i)
+              {
+                next_x_vals[i] = emitted[i].x;
+                next_y_vals[i] = emitted[i].y;
+              }
+              send_path(next_x_vals, next_y_vals);
+              return;
+            }
+            // the path may have been longer than the horizon of the current traffic
+            if(n_kept > horizon.points)
+            {
+              emitted.truncate(horizon.points);
+              lane_change.advance((horizon.points - n_kept) * .02);
+              n_kept = horizon.points;
+            }
 
-                  lane = ego.lane;
-                }
-                break;
-              case State::LCR:
-                {
-                  if(ego.right_front_dist < 30)
-                    too_close = true;
-                  ego.state = State::LCR;
-                  ego.lane = ego.lane + 1;
+            // Cruising alone in our lane at the speed limit, a full replan would
+            // give the same path again: only add the points the car drove
+            if(cruise.check(emitted, lanes.center(lane), lane_gaps.lane(lane).front_dist, cutting_in,
+                            lane != cur_lane || target_lane != cur_lane))
+            {
+              cruise.extend(ref_line, emitted, lanes.center(lane), horizon.points);
+              cout << "Steady cruise, path extended (" << cruise.fast_count << " fast, "
+                << cruise.full_count << " full, " << cruise.held_count << " held frames)\n";
 
-                  lane = ego.lane;
-                }
-                break;
-              default:
-                break;
+              vector<double> next_x_vals(emitted.size());
+              vector<double> next_y_vals(emitted.size());
+              for(int i = 0; i < emitted.size(); ++i)
+              {
+                next_x_vals[i] = emitted[i].x;
+                next_y_vals[i] = emitted[i].y;
+              }
+              send_path(next_x_vals, next_y_vals);
+              return;
             }
 
+            if(!predicted)
+              predict();
+            metrics.search_ms = decision.search_ms;
+            metrics.search_depth = decision.search_depth;
+
+            // check all posible next states
+            cout << "All possible next states are: \n" << decision.report;
+            lane = target_lane;
+            ego.state = lane == cur_lane ? State::KL : (lane < cur_lane ? State::LCL : State::LCR);
+            cout << "Behavior: lane " << lane << " decided " << 1000. * (now - decision.stamp)
+              << " ms ago at " << behavior.rate_hz << " Hz (" << decision.metrics.last_ms << " ms, mean "
+              << decision.metrics.mean_ms << " ms, max " << decision.metrics.max_ms << " ms); trajectory "
+              << trajectory_metrics.mean_ms << " ms mean, " << trajectory_metrics.max_ms << " ms max\n";
+
             // print out all the nearby car
             cout << "Goal distance: " << max_s << "\tCurrent distance: " 
               << ego.s << endl;
             cout << "Duration of Keep Lane: " << keep_duration << " seconds\n";
+            cout << "Latency: " << 1000. * lag_time << " ms (planning "
+              << 1000. * latency.planning_time() << " ms, " << latency.points_consumed()
+              << " points consumed, " << lag << " points skipped)\n";
 
-            for(int i=0; i < (int)vec_lane.size(); ++i)
+            for(int i=0; i < traffic.num_lanes; ++i)
             {
-              cout << "Nearby car in Lane " << i << " are \n";
-              for(int j=0; j < (int)vec_lane[i].size(); ++j)
+              const LaneGap &gap = lane_gaps.lane(i);
+              cout << "Nearby car in Lane " << i << " (front gap " << gap.front_dist
+                << " m, ttc " << gap.front_ttc << " s) are \n";
+              for(int j=traffic.lane_begin(i); j < traffic.lane_end(i); ++j)
               {
-                cout << vec_lane[i][j].id << " at s = " 
-                  << vec_lane[i][j].s - ego.s
-                  << " with speed = " << vec_lane[i][j].v  << endl;
+                cout << traffic.id[j] << " at s = " 
+                  << traffic.rel_s[j]
+                  << " with speed = " << traffic.vs[j]  << endl;
               }
               cout << endl;
             }
 
-            if(too_close)
-            {
-              ref_vel -= .224*1.5;  // slow down as acc 5 m/s^2
-            }
-            else if (ref_vel < 49.5)
+            // plan the speed from the end of the previous path, where the new points
+            // start; the new points span the time the car drove since the last frame,
+            // so the speed follows the profile no matter how often telemetry arrives
+            int n_new = max(horizon.points - n_kept, 0);
+            double t_end = n_kept * .02;
+            double d_lo = min(lanes.center(cur_lane), lanes.center(lane)) - .5 * lanes.lane_width;
+            double d_hi = max(lanes.center(cur_lane), lanes.center(lane)) + .5 * lanes.lane_width;
+            auto t_speed = chrono::steady_clock::now();
+            speed_planner.set_obstacles(prediction, car_s, t_end, d_lo, d_hi);
+            speed_planner.plan(end_v, end_a);
+
+            // the MPC follows the profile and the car ahead in the target lane smoothly,
+            // the car is seen from the path end at the time the path ends
+            double v_ref[LongitudinalMpc::N];
+            for(int k = 0; k < LongitudinalMpc::N; ++k)
+              v_ref[k] = speed_planner.speed_at((k + 1) * speed_mpc.dt);
+            const LaneGap &lead = lane_gaps.lane(lane);
+            bool has_lead = lead.front_id >= 0 && lead.front_dist < 150.;
+            double lead_gap = ego.s + lead.front_dist + lead.front_speed * t_end - car_s;
+            lead_gap = fmod(lead_gap + 1.5 * max_s, max_s) - .5 * max_s;  // the short way around
+            speed_mpc.solve(end_v, end_a, v_ref, has_lead, lead_gap, lead.front_speed);
+
+            // every new point gets its own speed from a jerk-limited S-curve towards
+            // where the MPC wants to be in a second, the path end carries over
+            vector<double> point_v(n_new);
+            vector<double> point_a(n_new);
+            s_curve.profile(end_v, end_a, speed_mpc.speed_at(1.), n_new, .02,
+                            point_v.data(), point_a.data());
+            metrics.speed_ms = chrono::duration<double, milli>(chrono::steady_clock::now() - t_speed).count();
+            metrics.mpc_iterations = speed_mpc.iterations();
+
+            // The new points in frenet: s from the point speeds and d moving to the
+            // center of target_lane. A lane change follows a primitive of the library,
+            // looked up when it starts and continued where the kept path ends, so the
+            // new points are only sampled; without a primitive, or to settle in our
+            // lane, d moves by a minimum-jerk quintic replanned every frame.
+            // They start at the end of our own last path, not at end_path_s, so the
+            // simulator's frenet conversion can't put a step into the speed. The
+            // conversion spaces the points by their speed in world coordinates, in
+            // the outer lanes of a curve the s steps alone would be too long.
+            double change_time = 2.5;
+            vector<double> frenet_s(n_new);
+            vector<double> frenet_d(n_new);
+            vector<double> frenet_x(n_new);
+            vector<double> frenet_y(n_new);
+            vector<double> frenet_step(n_new);
+            double lateral[6];
+            LaneChangePrimitive next_change;
+            auto frenet_points = [&](int target_lane)
             {
-              ref_vel += .224;  // speed up as acc 5 m/s^2
-            }
+              double target_d = lanes.center(target_lane);
+              next_change = lane_change;
+              bool follow = next_change.prim && fabs(next_change.target_d - target_d) < 1e-3;
+              if(!follow && fabs(end_vd) < .1 && fabs(end_ad) < .5)
+                follow = next_change.start(primitives, end_v, end_d, target_d, 2.5);
+              // a path extended or cut since then doesn't end on the primitive anymore
+              if(follow)
+              {
+                change_time = next_change.lateral(lateral);
+                follow = fabs(lateral[0] - end_d) < .05;
+              }
+              if(!follow)
+              {
+                next_change.prim = nullptr;
+                change_time = 2.5;
+                min_jerk_quintic(end_d, end_vd, end_ad, target_d, 0., 0., change_time, lateral);
+              }
+              double s = car_s;
+              for(int i = 0; i < n_new; ++i)
+              {
+                double t = min((i + 1) * .02, change_time);
+                frenet_step[i] = point_v[i] * .02;
+                s += frenet_step[i];
+                frenet_s[i] = s;
+                frenet_d[i] = lateral[0] + t * (lateral[1] + t * (lateral[2] + t * (lateral[3] + t * (lateral[4] + t * lateral[5]))));
+              }
+              ref_line.to_xy_spaced(car_s, end_d, frenet_step.data(), frenet_s.data(), frenet_d.data(),
+                                    n_new, frenet_x.data(), frenet_y.data());
+            };
 
-              
+            // Build the path to the center of target_lane after the previous path
+            auto build_path = [&](int target_lane, vector<double> &next_x_vals, vector<double> &next_y_vals)
+            {
+              if(frenet_pipeline)
+              {
+                for (int i = 0; i < n_kept; i++)
+                {
+                  next_x_vals.push_back(emitted[i].x);
+                  next_y_vals.push_back(emitted[i].y);
+                }
+                frenet_points(target_lane);
+                next_x_vals.insert(next_x_vals.end(), frenet_x.begin(), frenet_x.end());
+                next_y_vals.insert(next_y_vals.end(), frenet_y.begin(), frenet_y.end());
+                return;
+              }
 
-          	// TODO: define a path made up of (x,y) points that the car will visit sequentially every .02 seconds
-            // Create a list of widely spaced (x,y) waypoints, evenly spaced at 30m.
-            // Later, we will interpolate these waypoints with a spline and fill it in with more points that control speed.
-            vector<double> ptsx;
-            vector<double> ptsy;
-
-            // reference x, y, yaw state
-            // either we will reference the starting points as where the car is or at the previouse paths end point.
-            double ref_x = car_x;
-            double ref_y = car_y;
-            double ref_yaw = deg2rad(car_yaw);
+            	// TODO: define a path made up of (x,y) points that the car will visit sequentially every .02 seconds
+              // Create a list of widely spaced (x,y) waypoints, evenly spaced by the horizon.
+              // Later, we will interpolate these waypoints with a spline and fill it in with more points that control speed.
+              vector<double> ptsx;
+              vector<double> ptsy;
+
+              // reference x, y, yaw state
+              // either we will reference the starting points as where the car is or at the previouse paths end point.
+              double ref_x = car_x;
+              double ref_y = car_y;
+              double ref_yaw = deg2rad(car_yaw);
             
-            //if previous size is almost empty, use the car as starting reference
-            if(prev_size < 2)
-            {
-              // Use two points that make the path tangent to the car
-              double prev_car_x = car_x - cos(car_yaw);
-              double prev_car_y = car_y - sin(car_yaw);
+              //if previous size is almost empty, use the car as starting reference
+              if(n_kept < 2)
+              {
+                // Use two points that make the path tangent to the car
+                double prev_car_x = car_x - cos(car_yaw);
+                double prev_car_y = car_y - sin(car_yaw);
 
-              ptsx.push_back(prev_car_x);
-              ptsx.push_back(car_x);
+                ptsx.push_back(prev_car_x);
+                ptsx.push_back(car_x);
 
-              ptsy.push_back(prev_car_y);
-              ptsy.push_back(car_y);
+                ptsy.push_back(prev_car_y);
+                ptsy.push_back(car_y);
 
-            }
-            else // use the previous path's end points as starting reference
-            {
+              }
+              else // use the previous path's end points as starting reference
+              {
 
-              // Redefine reference state as previous path end point
-              ref_x = previous_path_x[prev_size - 1];
-              ref_y = previous_path_y[prev_size - 1];
+                // Redefine reference state as previous path end point
+                ref_x = emitted[n_kept - 1].x;
+                ref_y = emitted[n_kept - 1].y;
 
-              double ref_x_prev = previous_path_x[prev_size - 2];
-              double ref_y_prev = previous_path_y[prev_size - 2];
-              ref_yaw = atan2(ref_y - ref_y_prev, ref_x - ref_x_prev);
+                double ref_x_prev = emitted[n_kept - 2].x;
+                double ref_y_prev = emitted[n_kept - 2].y;
+                ref_yaw = atan2(ref_y - ref_y_prev, ref_x - ref_x_prev);
 
-              // Use two points that make the path tangent to the previous path's end point
-              ptsx.push_back(ref_x_prev);
-              ptsx.push_back(ref_x);
+                // Use two points that make the path tangent to the previous path's end point
+                ptsx.push_back(ref_x_prev);
+                ptsx.push_back(ref_x);
 
-              ptsy.push_back(ref_y_prev);
-              ptsy.push_back(ref_y);
+                ptsy.push_back(ref_y_prev);
+                ptsy.push_back(ref_y);
 
-            }
+              }
 
-            // In Frenet add evenly 30m spaced points ahead of the starting reference
-            vector<double> next_wp0 = getXY(car_s+30, (2+4*lane), map_waypoints_s, map_waypoints_x, map_waypoints_y);
-            vector<double> next_wp1 = getXY(car_s+60, (2+4*lane), map_waypoints_s, map_waypoints_x, map_waypoints_y);
-            vector<double> next_wp2 = getXY(car_s+90, (2+4*lane), map_waypoints_s, map_waypoints_x, map_waypoints_y);
+              // In Frenet add evenly spaced points ahead of the starting reference
+              double spacing = horizon.spacing;
+              vector<double> next_wp0 = getXY(car_s+spacing, lanes.center(target_lane), map_waypoints_s, map_waypoints_x, map_waypoints_y);
+              vector<double> next_wp1 = getXY(car_s+2*spacing, lanes.center(target_lane), map_waypoints_s, map_waypoints_x, map_waypoints_y);
+              vector<double> next_wp2 = getXY(car_s+3*spacing, lanes.center(target_lane), map_waypoints_s, map_waypoints_x, map_waypoints_y);
 
-            ptsx.push_back(next_wp0[0]);
-            ptsx.push_back(next_wp1[0]);
-            ptsx.push_back(next_wp2[0]);
+              ptsx.push_back(next_wp0[0]);
+              ptsx.push_back(next_wp1[0]);
+              ptsx.push_back(next_wp2[0]);
 
-            ptsy.push_back(next_wp0[1]);
-            ptsy.push_back(next_wp1[1]);
-            ptsy.push_back(next_wp2[1]);
+              ptsy.push_back(next_wp0[1]);
+              ptsy.push_back(next_wp1[1]);
+              ptsy.push_back(next_wp2[1]);
 
-            // shift car reference angle to 0 degree (transfer to car coordinates)
-            for(int i=0; i < (int)ptsx.size(); ++i)
-            {
-              double shift_x = ptsx[i]-ref_x;
-              double shift_y = ptsy[i]-ref_y;
+              // shift car reference angle to 0 degree (transfer to car coordinates)
+              for(int i=0; i < (int)ptsx.size(); ++i)
+              {
+                double shift_x = ptsx[i]-ref_x;
+                double shift_y = ptsy[i]-ref_y;
 
-              ptsx[i] = (shift_x * cos(0-ref_yaw) - shift_y * sin(0-ref_yaw));
-              ptsy[i] = (shift_x * sin(0-ref_yaw) + shift_y * cos(0-ref_yaw));
+                ptsx[i] = (shift_x * cos(0-ref_yaw) - shift_y * sin(0-ref_yaw));
+                ptsy[i] = (shift_x * sin(0-ref_yaw) + shift_y * cos(0-ref_yaw));
 
-            }
+              }
 
-            // Create a spline
-            tk::spline s;
+              // Create a spline
+              tk::spline s;
 
-            // set (x,y) points to the spline
-            s.set_points(ptsx, ptsy);
+              // set (x,y) points to the spline
+              s.set_points(ptsx, ptsy);
 
-            // Define the actual (x,y) points we will ue for the planner
-          	vector<double> next_x_vals;
-          	vector<double> next_y_vals;
 
-            // Start with all of the previous path points from last time
-            for (int i = 0; i < (int)previous_path_x.size(); i++) 
-            {
-              next_x_vals.push_back(previous_path_x[i]);
-              next_y_vals.push_back(previous_path_y[i]);
-            }
+              // Start with the previous path points the car hasn't driven yet
+              for (int i = 0; i < n_kept; i++)
+              {
+                next_x_vals.push_back(emitted[i].x);
+                next_y_vals.push_back(emitted[i].y);
+              }
 
-            // Calculate how to break up spline points so that we travel at our desired reference velocity
-            double target_x = 30.0;
-            double target_y = s(target_x);
-            double target_dist = sqrt( target_x*target_x + target_y*target_y );
+              // Calculate how to break up spline points so that we travel at our desired reference velocity
+              double target_x = spacing;
+              double target_y = s(target_x);
+              double target_dist = sqrt( target_x*target_x + target_y*target_y );
 
-            double x_add_on = 0;
+              double x_add_on = 0;
 
-            // Fill up the rest of our path planner after filling it with previous points, here we will always output 50 points
-            for (int i = 1; i < 50-(int)previous_path_x.size(); i++)
-            {
+              // Fill up the rest of our path planner after filling it with previous points, up to the horizon
+              for (int i = 1; i <= horizon.points-n_kept; i++)
+              {
 
-              double N = (target_dist/(.02*ref_vel/2.24));  // 2.24 for transfer mph to meter per seconds
-              double x_point = x_add_on + (target_x) / N;
-              double y_point = s(x_point);
+                double N = (target_dist/(.02*point_v[i-1]));  // points to cover target_dist at the speed of this point
+                double x_point = x_add_on + (target_x) / N;
+                double y_point = s(x_point);
               
 
-              x_add_on = x_point;
+                x_add_on = x_point;
 
-              double x_ref = x_point;
-              double y_ref = y_point;
+                double x_ref = x_point;
+                double y_ref = y_point;
 
-              // rotate back to normal after rotating it earlier (back to world coordinates)
-              x_point = (x_ref * cos(ref_yaw) - y_ref * sin(ref_yaw));
-              y_point = (x_ref * sin(ref_yaw) + y_ref * cos(ref_yaw));
+                // rotate back to normal after rotating it earlier (back to world coordinates)
+                x_point = (x_ref * cos(ref_yaw) - y_ref * sin(ref_yaw));
+                y_point = (x_ref * sin(ref_yaw) + y_ref * cos(ref_yaw));
 
-              x_point += ref_x;
-              y_point += ref_y;
+                x_point += ref_x;
+                y_point += ref_y;
 
-              next_x_vals.push_back(x_point);
-              next_y_vals.push_back(y_point);
+                next_x_vals.push_back(x_point);
+                next_y_vals.push_back(y_point);
               
+              }
+            };
+
+            // Every possible next state is a candidate, its cost from the gaps is a
+            // lower bound of the exact cost, which adds what only the built path
+            // tells: how close it gets to the acceleration and jerk limits and how
+            // early it passes a car too close. Candidates are evaluated in order of
+            // their bound, the rest is skipped as soon as a bound can't beat the
+            // best exact cost.
+            // The behavior layer gave the cost of the lanes next to us, our own lane
+            // is always a candidate.
+            candidates.clear(max(n_kept, horizon.points));
+            for(int ln = cur_lane - 1; ln <= cur_lane + 1; ++ln)
+            {
+              double cost = decision.cost(ln);
+              if(ln == cur_lane)
+                candidates.add(State::KL, ln, cost < 1e9 ? cost : 0.);
+              else if(ln >= 0 && ln < num_lanes && cost < 1e9)
+                candidates.add(ln < cur_lane ? State::LCL : State::LCR, ln, cost);
             }
 
+            vector<double> path_x;
+            vector<double> path_y;
+            int best = branch_and_bound(candidates, metrics, [&](int c)
+            {
+              path_x.clear();
+              path_y.clear();
+              build_path(candidates.lane[c], path_x, path_y);
+              candidates.set_path(c, path_x, path_y);
+              candidates.survivors.assign(1, c);
+
+              auto t_start = chrono::steady_clock::now();
+              metrics.feasible += feasibility.filter(candidates);
+              metrics.feasibility_ms += chrono::duration<double, milli>(chrono::steady_clock::now() - t_start).count();
+              if(candidates.survivors.empty())
+                return 1e9;
+              return candidates.bound[c] + feasibility.margin_cost(c);
+            }, [&](CandidateBatch &batch)
+            {
+              // Frenet occupancy is coarse in curves, check all paths still alive in
+              // world coordinates at once
+              auto t_start = chrono::steady_clock::now();
+              const int *alive = batch.survivors.data();
+              int n_alive = batch.survivors.size();
+              obb.check_batch(batch.x.data(), batch.y.data(), batch.n_points,
+                              alive, n_alive, batch.first_hit.data());
+              near_miss.check_batch(batch.x.data(), batch.y.data(), batch.n_points,
+                                    alive, n_alive, batch.near_hit.data());
+              metrics.collision_ms += chrono::duration<double, milli>(chrono::steady_clock::now() - t_start).count();
+
+              auto last = remove_if(batch.survivors.begin(), batch.survivors.end(),
+                                    [&batch](int c) { return batch.first_hit[c] >= 0; });
+              batch.survivors.erase(last, batch.survivors.end());
+              metrics.collision_free += batch.survivors.size();
+
+              // the earlier a path passes a car too close, the riskier it is
+              for(int c : batch.survivors)
+              {
+                int close = batch.near_hit[c];
+                if(close >= 0)
+                  batch.cost[c] += 30. * (1. - (double)close / batch.n_points);
+              }
+            }, 1e9, &deadline);
 
-          	json msgJson;
-          	msgJson["next_x"] = next_x_vals;
-          	msgJson["next_y"] = next_y_vals;
+            // keep lane if no candidate survived or the deadline cut the evaluation
+            // short, extending the previous path is always possible
+            if(best < 0)
+            {
+              best = 0;
+              for(int c = 0; c < candidates.size; ++c)
+              {
+                if(candidates.lane[c] == cur_lane)
+                  best = c;
+              }
+              path_x.clear();
+              path_y.clear();
+              build_path(candidates.lane[best], path_x, path_y);
+              candidates.set_path(best, path_x, path_y);
+            }
+            // remember the new points of the chosen path with the state at each of
+            // them, the next path starts from the last one
+            if(frenet_pipeline && n_new > 0)
+            {
+              frenet_points(candidates.lane[best]);
+              lane_change = next_change;
+              lane_change.advance(n_new * .02);
+            }
+            for(int i = 0; i < n_new && n_kept + i < candidates.n_points; ++i)
+            {
+              PathPoint p;
+              p.x = candidates.xs(best)[n_kept + i];
+              p.y = candidates.ys(best)[n_kept + i];
+              p.v = point_v[i];
+              p.a = point_a[i];
+              PathPoint prev;
+              if(emitted.empty())
+              {
+                prev.x = car_x - cos(deg2rad(car_yaw));
+                prev.y = car_y - sin(deg2rad(car_yaw));
+                prev.d = end_d;
+                prev.vd = end_vd;
+              }
+              else
+                prev = emitted.back();
+              if(frenet_pipeline)
+              {
+                double t = min((i + 1) * .02, change_time);
+                p.s = fmod(frenet_s[i], max_s);
+                p.d = frenet_d[i];
+                p.vd = lateral[1] + t * (2. * lateral[2] + t * (3. * lateral[3] + t * (4. * lateral[4] + t * 5. * lateral[5])));
+                p.ad = 2. * lateral[2] + t * (6. * lateral[3] + t * (12. * lateral[4] + t * 20. * lateral[5]));
+              }
+              else
+              {
+                // the spline only knows x and y, go back to frenet along the path heading
+                vector<double> frenet = getFrenet(p.x, p.y, atan2(p.y - prev.y, p.x - prev.x),
+                                                  map_waypoints_x, map_waypoints_y);
+                p.s = frenet[0];
+                p.d = frenet[1];
+                p.vd = (p.d - prev.d) / .02;
+                p.ad = (p.vd - prev.vd) / .02;
+              }
+              emitted.push(p);
+            }
+            if(candidates.lane[best] != lane)
+            {
+              cout << "Path to lane " << lane << " rejected, go to lane "
+                << candidates.lane[best] << endl;
+              lane = candidates.lane[best];
+            }
+            cout << "Candidates: " << metrics.generated << " pruned: " << metrics.pruned
+              << " (" << 100. * metrics.prune_rate() << "%) feasible: " << metrics.feasible
+              << " collision free: " << metrics.collision_free << " (prediction "
+              << metrics.prediction_ms << " ms, feasibility " << metrics.feasibility_ms
+              << " ms, collision " << metrics.collision_ms << " ms, search "
+              << metrics.search_ms << " ms, speed " << metrics.speed_ms << " ms, "
+              << metrics.mpc_iterations << " mpc iterations, depth " << metrics.search_depth << ", "
+              << metrics.cut_off << " cut off)\n";
+
+            cout << "Horizon: " << horizon.points << " points, anchors every " << horizon.spacing
+              << " m, replan every " << horizon.period << " frames (density " << horizon.density << ")\n";
+            cout << "Steady cruise in " << 100. * cruise.fast_rate() << "% of the frames ("
+              << cruise.fast_count << " fast, " << cruise.full_count << " full, "
+              << cruise.held_count << " held)\n";
 
-          	auto msg = "42[\"control\","+ msgJson.dump()+"]";
+            // Define the actual (x,y) points we will ue for the planner
+          	vector<double> next_x_vals(candidates.xs(best), candidates.xs(best) + candidates.n_points);
+          	vector<double> next_y_vals(candidates.ys(best), candidates.ys(best) + candidates.n_points);
 
-          	//this_thread::sleep_for(chrono::milliseconds(1000));
-          	ws.send(msg.data(), msg.length(), uWS::OpCode::TEXT);
+          	send_path(next_x_vals, next_y_vals);
           
         }
       } else {
@@ -0,0 +1,209 @@
+#include <algorithm>
+#include <math.h>
+#include "maneuver_search.h"
+
+static const double rejected = 1e9;
+
+/*
+ * Initialize ManeuverSearch
+ */
+
+ManeuverSearch::ManeuverSearch(double max_s, WorkerPool *pool, int depth, int beam_width,
+                               double step_time, double lane_width, int capacity)
+{
+  this->max_s = max_s;
+  this->step_time = step_time;
+  this->lane_width = lane_width;
+  this->v_max = 49.5 / 2.24;
+  this->acc = 3.;
+  this->headway = 1.0;
+  this->min_gap = 10.;
+  this->change_cost = 5.;
+  this->depth = depth;
+  this->beam_width = beam_width;
+
+  pool_ = pool;
+  capacity_ = capacity;
+  n_cars_ = 0;
+  num_lanes_ = 3;
+  best_ = -1;
+  expanded_ = 0;
+  depth_reached_ = 0;
+
+  // the root, then three children for every beam node of every depth
+  nodes_.resize(1 + depth * beam_width * 3);
+  beam_.reserve(beam_width);
+  order_.reserve(beam_width * 3);
+  car_s_.assign((depth + 1) * capacity, 0.);
+  car_v_.assign((depth + 1) * capacity, 0.);
+  car_lane_.assign((depth + 1) * capacity, 0);
+}
+
+
+void ManeuverSearch::sample_cars(const Prediction &pred, double ego_s)
+{
+  n_cars_ = std::min(pred.size, capacity_);
+  int last = pred.num_steps - 1;
+  for(int j = 0; j <= depth; ++j)
+  {
+    double time = j * step_time;
+    int t = std::min((int)lround(time / pred.dt), last);
+    int t0 = std::max(t - 1, 0);
+    double extra = time - t * pred.dt;
+    double *s = &car_s_[j * capacity_];
+    double *v = &car_v_[j * capacity_];
+    int *ln = &car_lane_[j * capacity_];
+    for(int i = 0; i < n_cars_; ++i)
+    {
+      v[i] = (t > t0) ? (pred.s(t, i) - pred.s(t0, i)) / ((t - t0) * pred.dt) : 0.;
+      // the short way around the track to the ego now
+      double ds = fmod(pred.s(t, i) - ego_s, max_s);
+      if(ds >= 0.5 * max_s)
+        ds -= max_s;
+      else if(ds < -0.5 * max_s)
+        ds += max_s;
+      s[i] = ds + v[i] * std::max(extra, 0.);
+      ln[i] = (int)floor(pred.d(t, i) / lane_width);
+    }
+  }
+}
+
+
+void ManeuverSearch::expand(const Node &from, State action, int j, Node &to) const
+{
+  int ln = from.lane + (action == State::LCL ? -1 : (action == State::LCR ? 1 : 0));
+  to.action = action;
+  to.lane = ln;
+  to.cost = rejected;
+  if(ln < 0 || ln >= num_lanes_)
+    return;
+
+  // nearest car ahead in the new lane at the end of the maneuver, and
+  // for a lane change any car next to us at its start or end
+  const double *s0 = &car_s_[(j - 1) * capacity_];
+  const double *s1 = &car_s_[j * capacity_];
+  const double *v1 = &car_v_[j * capacity_];
+  const int *ln0 = &car_lane_[(j - 1) * capacity_];
+  const int *ln1 = &car_lane_[j * capacity_];
+  double v_new = std::min(from.v + acc * step_time, v_max);
+  double s_free = from.s + 0.5 * (from.v + v_new) * step_time;
+  double lead_s = 1e9;
+  double lead_v = v_max;
+  for(int i = 0; i < n_cars_; ++i)
+  {
+    if(action != State::KL &&
+       ((ln0[i] == ln && fabs(s0[i] - from.s) < min_gap) ||
+        (ln1[i] == ln && fabs(s1[i] - s_free) < min_gap)))
+      return;
+    if(ln1[i] == ln && s1[i] > from.s && s1[i] < lead_s)
+    {
+      lead_s = s1[i];
+      lead_v = v1[i];
+    }
+  }
+
+  // follow the car ahead when it is within the time gap
+  double s_new = s_free;
+  if(lead_s - s_free < min_gap + headway * v_new)
+  {
+    v_new = std::min(v_new, std::max(lead_v, 0.));
+    s_new = std::max(std::min(s_free, lead_s - min_gap), from.s);
+  }
+
+  to.s = s_new;
+  to.v = v_new;
+  to.cost = from.cost + (v_max * step_time - (s_new - from.s)) +
+            (action == State::KL ? 0. : change_cost);
+}
+
+
+void ManeuverSearch::search(const Prediction &pred, double ego_s, int ego_lane, double ego_v,
+                            int num_lanes, const Deadline *deadline)
+{
+  num_lanes_ = num_lanes;
+  sample_cars(pred, ego_s);
+
+  Node &root = nodes_[0];
+  root.parent = -1;
+  root.action = State::KL;
+  root.first = State::KL;
+  root.lane = ego_lane;
+  root.s = 0.;
+  root.v = ego_v;
+  root.cost = 0.;
+
+  beam_.assign(1, 0);
+  expanded_ = 0;
+  depth_reached_ = 0;
+  best_ = -1;
+  int base = 1;
+  for(int j = 1; j <= depth; ++j)
+  {
+    int n_children = beam_.size() * 3;
+    auto expand_children = [this, base, j](int begin, int end)
+    {
+      for(int c = begin; c < end; ++c)
+      {
+        int parent = beam_[c / 3];
+        Node &child = nodes_[base + c];
+        child.parent = parent;
+        expand(nodes_[parent], (State)(c % 3), j, child);
+        child.first = (j == 1) ? child.action : nodes_[parent].first;
+      }
+    };
+    if(pool_)
+      pool_->run(n_children, 3, expand_children);
+    else
+      expand_children(0, n_children);
+    expanded_ += n_children;
+
+    // keep the cheapest children
+    order_.clear();
+    for(int c = 0; c < n_children; ++c)
+    {
+      if(nodes_[base + c].cost < rejected)
+        order_.push_back(base + c);
+    }
+    if(order_.empty())
+      break;
+    int keep = std::min((int)order_.size(), beam_width);
+    std::partial_sort(order_.begin(), order_.begin() + keep, order_.end(),
+                      [this](int a, int b) { return nodes_[a].cost < nodes_[b].cost; });
+    beam_.assign(order_.begin(), order_.begin() + keep);
+    best_ = beam_[0];
+    depth_reached_ = j;
+    base += n_children;
+
+    if(deadline && deadline->expired())
+      break;
+  }
+}
+
+
+double ManeuverSearch::regret(State first, double cap) const
+{
+  if(best_ < 0)
+    return 0.;
+
+  // the beam holds the deepest nodes reached, sorted by cost
+  for(int b : beam_)
+  {
+    if(nodes_[b].first == first)
+      return std::min(nodes_[b].cost - nodes_[best_].cost, cap);
+  }
+
+  return cap;
+}
+
+
+int ManeuverSearch::best_sequence(State *seq) const
+{
+  int n = 0;
+  for(int b = best_; b > 0; b = nodes_[b].parent)
+    ++n;
+  int k = n;
+  for(int b = best_; b > 0; b = nodes_[b].parent)
+    seq[--k] = nodes_[b].action;
+
+  return n;
+}
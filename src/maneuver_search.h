@@ -0,0 +1,100 @@
+#ifndef MANEUVER_SEARCH_H
+#define MANEUVER_SEARCH_H
+#include <vector>
+#include "vehicle.h"
+#include "prediction.h"
+#include "worker_pool.h"
+#include "deadline.h"
+
+using std::vector;
+
+/*
+ * Beam search over sequences of maneuvers.
+ *
+ * A node is the ego car after a few maneuvers of `step_time` seconds
+ * each: its lane, how far it got and how fast it goes. Expanding a node
+ * tries KL, LCL and LCR; the ego speeds up towards v_max unless a car
+ * predicted ahead in the new lane holds it back, and a lane change into
+ * a predicted car is rejected. The cost of a node is the distance it
+ * lost against driving at v_max plus a small cost per lane change, so
+ * "change left, then back right to pass" wins when the slow car ahead
+ * costs more than the two changes.
+ *
+ * The cars are sampled once per search from the prediction buffers (and
+ * extended at constant speed beyond their horizon). Nodes live in a pool
+ * sized for the whole tree at construction, the children of a depth are
+ * expanded in parallel on the worker pool, each into its own slot.
+ *
+ * The search deepens one maneuver at a time, so when a deadline expires
+ * the beam of the last finished depth is the answer.
+ */
+class ManeuverSearch
+{
+public:
+  double max_s;        // length of the track before s wraps around
+  double step_time;    // duration of one maneuver [s]
+  double lane_width;
+  double v_max;        // speed the ego goes for [m/s]
+  double acc;          // speed up of the ego during a maneuver [m/s^2]
+  double headway;      // time gap kept to a car ahead [s]
+  double min_gap;      // distance kept to a car ahead [m]
+  double change_cost;  // cost of a lane change in lost meters
+  int depth;           // maneuvers per sequence
+  int beam_width;      // nodes kept at every depth
+
+  /*
+   * Constructor, without a pool everything runs on the calling thread
+   */
+  ManeuverSearch(double max_s, WorkerPool *pool=nullptr, int depth=4, int beam_width=8,
+                 double step_time=1.5, double lane_width=4., int capacity=256);
+
+  // search from the ego at (ego_s, ego_lane) going ego_v [m/s] on a road of num_lanes
+  void search(const Prediction &pred, double ego_s, int ego_lane, double ego_v, int num_lanes,
+              const Deadline *deadline=nullptr);
+
+  /*
+   * How much worse in lost meters the best sequence starting with `first`
+   * is than the best one overall, `cap` if the beam dropped all of them.
+   */
+  double regret(State first, double cap=50.) const;
+
+  // maneuvers of the best sequence, returns its length
+  int best_sequence(State *seq) const;
+
+  int expanded() const { return expanded_; }
+
+  // depth of the nodes in the final beam
+  int depth_reached() const { return depth_reached_; }
+
+private:
+  struct Node
+  {
+    int parent;
+    State action;
+    State first;  // first maneuver of the sequence leading here
+    int lane;
+    double s;     // relative to the ego now
+    double v;
+    double cost;
+  };
+
+  WorkerPool *pool_;
+  int capacity_;
+  int n_cars_;
+  int num_lanes_;
+  int best_;
+  int expanded_;
+  int depth_reached_;
+
+  vector<Node> nodes_;   // whole tree, depth by depth
+  vector<int> beam_;     // nodes kept at the current depth
+  vector<int> order_;    // scratch to pick the next beam
+  vector<double> car_s_;   // (depth, car) s relative to the ego now
+  vector<double> car_v_;
+  vector<int> car_lane_;
+
+  void sample_cars(const Prediction &pred, double ego_s);
+  void expand(const Node &from, State action, int depth, Node &to) const;
+};
+
+#endif
@@ -0,0 +1,17 @@
+#ifndef MLP_DENSE_H
+#define MLP_DENSE_H
+
+/*
+ * Dense layer of the learned predictor for all cars at once:
+ *
+ *   out[j][v] = b[j] + sum_k W[j][k] * in[k][v]   (ReLU if relu)
+ *
+ * Activations are feature-major with `stride` cars per row. The AVX2 and
+ * FMA kernel lives in its own file, the only one built with -mavx2 -mfma,
+ * so the planner still runs on CPUs without them; MlpPredictor asks the
+ * CPU before it calls it.
+ */
+void dense_avx2(const float *W, const float *b, int n_in, int n_out,
+                const float *in, float *out, int n_cars, int stride, bool relu);
+
+#endif
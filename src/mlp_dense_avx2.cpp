@@ -0,0 +1,39 @@
+#ifdef __AVX2__
+#include <immintrin.h>
+#include "mlp_dense.h"
+
+void dense_avx2(const float *W, const float *b, int n_in, int n_out,
+                const float *in, float *out, int n_cars, int stride, bool relu)
+{
+  const __m256 zero = _mm256_setzero_ps();
+  for(int j = 0; j < n_out; ++j)
+  {
+    const float *w = W + j * n_in;
+    float *o = out + j * stride;
+    int v = 0;
+    for(; v + 8 <= n_cars; v += 8)
+    {
+      __m256 acc = _mm256_set1_ps(b[j]);
+      for(int k = 0; k < n_in; ++k)
+      {
+        __m256 x = _mm256_loadu_ps(in + k * stride + v);
+#ifdef __FMA__
+        acc = _mm256_fmadd_ps(_mm256_set1_ps(w[k]), x, acc);
+#else
+        acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_set1_ps(w[k]), x));
+#endif
+      }
+      if(relu)
+        acc = _mm256_max_ps(acc, zero);
+      _mm256_storeu_ps(o + v, acc);
+    }
+    for(; v < n_cars; ++v)
+    {
+      float acc = b[j];
+      for(int k = 0; k < n_in; ++k)
+        acc += w[k] * in[k * stride + v];
+      o[v] = (relu && acc < 0.f) ? 0.f : acc;
+    }
+  }
+}
+#endif
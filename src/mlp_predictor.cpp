@@ -0,0 +1,251 @@
+#include <algorithm>
+#include <fstream>
+#include <cstring>
+#include <math.h>
+#include "mlp_predictor.h"
+#include "mlp_dense.h"
+
+using std::ifstream;
+
+// one dense layer for all cars: out[j][v] = b[j] + sum_k W[j][k] * in[k][v]
+// Each weight scales a whole row of cars, the inner loop is a plain
+// multiply-add over contiguous floats which the compiler vectorizes.
+static void dense(const float *W, const float *b, int n_in, int n_out,
+                  const float *in, float *out, int n_cars, int stride, bool relu)
+{
+  for(int j = 0; j < n_out; ++j)
+  {
+    const float *w = W + j * n_in;
+    float *o = out + j * stride;
+    const float bj = b[j];
+    for(int v = 0; v < n_cars; ++v)
+      o[v] = bj;
+    for(int k = 0; k < n_in; ++k)
+    {
+      const float wk = w[k];
+      const float *x = in + k * stride;
+      for(int v = 0; v < n_cars; ++v)
+        o[v] += wk * x[v];
+    }
+    if(relu)
+    {
+      for(int v = 0; v < n_cars; ++v)
+        o[v] = o[v] < 0.f ? 0.f : o[v];
+    }
+  }
+}
+
+// the AVX2 kernel is only built when the compiler knows the instructions,
+// and only called when the CPU has them
+static bool cpu_has_avx2()
+{
+#if defined(MLP_AVX2_KERNEL) && (defined(__GNUC__) || defined(__clang__))
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#else
+  return false;
+#endif
+}
+
+/*
+ * Initialize MlpPredictor
+ */
+
+MlpPredictor::MlpPredictor(int capacity, double lane_width)
+{
+  horizons = {1., 2., 3.};
+  this->lane_width = lane_width;
+  capacity_ = capacity;
+  stride_ = (capacity + 7) / 8 * 8;
+  size_ = 0;
+  max_width_ = num_features;
+  out_ = nullptr;
+  avx2_ = cpu_has_avx2();
+  allocate();
+}
+
+
+void MlpPredictor::allocate()
+{
+  act_[0].assign(max_width_ * stride_, 0.f);
+  act_[1].assign(max_width_ * stride_, 0.f);
+  out_ = act_[0].data();
+}
+
+
+bool MlpPredictor::set_layers(const vector<int> &sizes, const vector<vector<float> > &weights,
+                              const vector<vector<float> > &biases)
+{
+  int n_layers = sizes.size() / 2;
+  if(n_layers < 1 || (int)weights.size() != n_layers || (int)biases.size() != n_layers)
+    return false;
+
+  // the network has to start at our features and end at our corrections
+  vector<Layer> layers(n_layers);
+  int width = num_features;
+  int max_width = num_features;
+  for(int l = 0; l < n_layers; ++l)
+  {
+    Layer &ly = layers[l];
+    ly.n_in = sizes[2 * l];
+    ly.n_out = sizes[2 * l + 1];
+    if(ly.n_in != width || ly.n_out <= 0 ||
+       (int)weights[l].size() != ly.n_in * ly.n_out || (int)biases[l].size() != ly.n_out)
+      return false;
+    ly.W = weights[l];
+    ly.b = biases[l];
+    width = ly.n_out;
+    max_width = std::max(max_width, width);
+  }
+  if(width != 2 * (int)horizons.size())
+    return false;
+
+  layers_.swap(layers);
+  max_width_ = max_width;
+  allocate();
+  return true;
+}
+
+
+bool MlpPredictor::load(const string &file)
+{
+  ifstream in(file.c_str(), ifstream::binary);
+  if(!in.is_open())
+    return false;
+
+  char magic[4];
+  int n_layers = 0;
+  in.read(magic, 4);
+  in.read((char *)&n_layers, sizeof(int));
+  if(!in || memcmp(magic, "MLP1", 4) != 0 || n_layers < 1 || n_layers > 16)
+    return false;
+
+  vector<int> sizes(2 * n_layers);
+  vector<vector<float> > weights(n_layers);
+  vector<vector<float> > biases(n_layers);
+  for(int l = 0; l < n_layers; ++l)
+  {
+    in.read((char *)&sizes[2 * l], 2 * sizeof(int));
+    int n_in = sizes[2 * l];
+    int n_out = sizes[2 * l + 1];
+    if(!in || n_in <= 0 || n_out <= 0 || n_in > 1024 || n_out > 1024)
+      return false;
+    weights[l].resize(n_in * n_out);
+    biases[l].resize(n_out);
+    in.read((char *)weights[l].data(), weights[l].size() * sizeof(float));
+    in.read((char *)biases[l].data(), biases[l].size() * sizeof(float));
+    if(!in)
+      return false;
+  }
+
+  return set_layers(sizes, weights, biases);
+}
+
+
+void MlpPredictor::features(const TrafficSnapshot &traffic, const Tracker &tracker)
+{
+  size_ = std::min(traffic.size, capacity_);
+  float *x = act_[0].data();
+  std::fill(act_[0].begin(), act_[0].begin() + num_features * stride_, 0.f);
+
+  for(int i = 0; i < size_; ++i)
+  {
+    // recent history relative to now, newest sample first
+    const Track *tr = tracker.find(traffic.id[i]);
+    if(tr)
+    {
+      int n = std::min(tr->history.size(), (int)history_len);
+      for(int k = 0; k < n; ++k)
+      {
+        const TrackSample &smp = tr->history[tr->history.size() - 1 - k];
+        x[(3 * k) * stride_ + i] = (float)(smp.d - traffic.d[i]);
+        x[(3 * k + 1) * stride_ + i] = (float)(smp.vs * 0.05);
+        x[(3 * k + 2) * stride_ + i] = (float)smp.vd;
+      }
+    }
+
+    // neighbors in the same lane, the snapshot is sorted by s inside a lane
+    int f = 3 * history_len;
+    int ln = traffic.lane[i];
+    bool has_front = (i + 1 < traffic.lane_end(ln));
+    bool has_back = (i > traffic.lane_begin(ln));
+    double front_gap = has_front ? traffic.rel_s[i + 1] - traffic.rel_s[i] : 100.;
+    double back_gap = has_back ? traffic.rel_s[i] - traffic.rel_s[i - 1] : 100.;
+    x[f * stride_ + i] = (float)(std::min(front_gap, 100.) * 0.01);
+    x[(f + 1) * stride_ + i] = has_front ? (float)((traffic.vs[i + 1] - traffic.vs[i]) * 0.1) : 0.f;
+    x[(f + 2) * stride_ + i] = (float)(std::min(back_gap, 100.) * 0.01);
+    x[(f + 3) * stride_ + i] = has_back ? (float)((traffic.vs[i - 1] - traffic.vs[i]) * 0.1) : 0.f;
+    // where the car is inside its lane
+    x[(f + 4) * stride_ + i] = (float)(fmod(traffic.d[i], lane_width) / lane_width - 0.5);
+    x[(f + 5) * stride_ + i] = (float)(traffic.vs[i] * 0.05);
+  }
+}
+
+
+void MlpPredictor::infer()
+{
+  if(layers_.empty())
+    return;
+
+  int cur = 0;
+  for(int l = 0; l < (int)layers_.size(); ++l)
+  {
+    const Layer &ly = layers_[l];
+    bool last = (l + 1 == (int)layers_.size());
+#ifdef MLP_AVX2_KERNEL
+    if(avx2_)
+      dense_avx2(ly.W.data(), ly.b.data(), ly.n_in, ly.n_out,
+                 act_[cur].data(), act_[1 - cur].data(), size_, stride_, !last);
+    else
+#endif
+      dense(ly.W.data(), ly.b.data(), ly.n_in, ly.n_out,
+            act_[cur].data(), act_[1 - cur].data(), size_, stride_, !last);
+    cur = 1 - cur;
+  }
+  out_ = act_[cur].data();
+}
+
+
+void MlpPredictor::apply(Prediction &pred) const
+{
+  if(layers_.empty())
+    return;
+
+  int n = std::min(size_, pred.size);
+  int n_h = horizons.size();
+  // a correction may not move a car off the road, same as the prediction itself
+  const double lo = pred.min_d;
+  const double hi = pred.max_d;
+  for(int t = 1; t < pred.num_steps; ++t)
+  {
+    // interpolate the corrections linearly in time, starting from 0 now
+    double time = t * pred.dt;
+    int h = 0;
+    while(h < n_h - 1 && horizons[h] < time)
+      ++h;
+    double t0 = (h == 0) ? 0. : horizons[h - 1];
+    double w = std::min((time - t0) / (horizons[h] - t0), 1.);
+
+    double *s = pred.s_row(t);
+    double *d = pred.d_row(t);
+    for(int i = 0; i < n; ++i)
+    {
+      double ds0 = (h == 0) ? 0. : out_[(2 * (h - 1)) * stride_ + i];
+      double dd0 = (h == 0) ? 0. : out_[(2 * (h - 1) + 1) * stride_ + i];
+      s[i] += ds0 + w * (out_[(2 * h) * stride_ + i] - ds0);
+      double di = d[i] + dd0 + w * (out_[(2 * h + 1) * stride_ + i] - dd0);
+      d[i] = di < lo ? lo : (di > hi ? hi : di);
+    }
+  }
+}
+
+
+void MlpPredictor::refine(const TrafficSnapshot &traffic, const Tracker &tracker, Prediction &pred)
+{
+  if(layers_.empty())
+    return;
+
+  features(traffic, tracker);
+  infer();
+  apply(pred);
+}
@@ -0,0 +1,96 @@
+#ifndef MLP_PREDICTOR_H
+#define MLP_PREDICTOR_H
+#include <string>
+#include <vector>
+#include "traffic.h"
+#include "tracker.h"
+#include "prediction.h"
+
+using std::string;
+using std::vector;
+
+/*
+ * Learned correction of the motion prediction.
+ *
+ * A small multi-layer perceptron looks at the recent frenet history of
+ * every car and at its gaps to the cars ahead and behind in its lane, and
+ * predicts how far the car will end up from the kinematic prediction at
+ * a few horizons. The correction is added on top of a Prediction, so a
+ * network with zero output is exactly the kinematic baseline.
+ *
+ * All cars go through the network together: activations are stored
+ * feature by feature with the cars side by side, and every layer is a
+ * broadcast-multiply-add over 8 cars at a time with AVX2 when the CPU has
+ * it, over rows of cars the compiler vectorizes otherwise. Weights are
+ * float32 and read from a binary file:
+ *
+ *   "MLP1", int32 number of layers, then per layer
+ *   int32 n_in, int32 n_out, float W[n_out][n_in], float b[n_out]
+ *
+ * Hidden layers use ReLU, the last layer is linear with 2 outputs per
+ * horizon (ds, dd). No trained weights ship with the project: without a
+ * weights file the predictor stays unloaded and refine() does nothing.
+ */
+class MlpPredictor
+{
+public:
+  static const int history_len = 8;   // samples of history per car
+  static const int num_features = 32; // inputs of the first layer, zero padded
+
+  vector<double> horizons;  // times of the corrections [s]
+  double lane_width;        // for where a car is inside its lane [m]
+
+  /*
+   * Constructor
+   */
+  MlpPredictor(int capacity=256, double lane_width=4.);
+
+  // read the weights, returns false and stays unloaded if the file doesn't fit
+  bool load(const string &file);
+
+  // use the given layers directly, sizes as in the file
+  bool set_layers(const vector<int> &sizes, const vector<vector<float> > &weights,
+                  const vector<vector<float> > &biases);
+
+  bool loaded() const { return !layers_.empty(); }
+
+  // name of the kernel the layers run on, "avx2" or "scalar"
+  const char *kernel() const { return avx2_ ? "avx2" : "scalar"; }
+
+  // fill the input features of every car of the snapshot
+  void features(const TrafficSnapshot &traffic, const Tracker &tracker);
+
+  // run the network on the features of all cars
+  void infer();
+
+  // add the corrections to the kinematic prediction of the same snapshot
+  void apply(Prediction &pred) const;
+
+  // features(), infer() and apply() in one go
+  void refine(const TrafficSnapshot &traffic, const Tracker &tracker, Prediction &pred);
+
+  // correction of car i at horizon h
+  float ds(int i, int h) const { return out_[(2 * h) * stride_ + i]; }
+  float dd(int i, int h) const { return out_[(2 * h + 1) * stride_ + i]; }
+
+private:
+  struct Layer
+  {
+    int n_in, n_out;
+    vector<float> W;  // n_out x n_in, row-major
+    vector<float> b;
+  };
+
+  vector<Layer> layers_;
+  int capacity_;
+  int stride_;   // cars per activation row, a multiple of 8
+  int size_;     // cars in the current batch
+  int max_width_;
+  bool avx2_;    // the CPU runs the AVX2 kernel
+  vector<float> act_[2];  // ping-pong activations, feature-major
+  const float *out_;
+
+  void allocate();
+};
+
+#endif
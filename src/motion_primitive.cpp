@@ -0,0 +1,213 @@
+#include <algorithm>
+#include <cstring>
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "motion_primitive.h"
+
+static double poly(const float *c, double t)
+{
+  return c[0] + t * (c[1] + t * (c[2] + t * (c[3] + t * (c[4] + t * c[5]))));
+}
+
+void min_jerk_quintic(double p0, double v0, double a0, double p1, double v1, double a1,
+                      double T, double *c)
+{
+  double T2 = T * T, T3 = T2 * T, T4 = T3 * T, T5 = T4 * T;
+  double r0 = p1 - (p0 + v0 * T + 0.5 * a0 * T2);
+  double r1 = v1 - (v0 + a0 * T);
+  double r2 = a1 - a0;
+  c[0] = p0;
+  c[1] = v0;
+  c[2] = 0.5 * a0;
+  c[3] = (10. * r0 - 4. * r1 * T + 0.5 * r2 * T2) / T3;
+  c[4] = (-15. * r0 + 7. * r1 * T - r2 * T2) / T4;
+  c[5] = (6. * r0 - 3. * r1 * T + 0.5 * r2 * T2) / T5;
+}
+
+double MotionPrimitive::s(double t) const
+{
+  return poly(s_coef, t);
+}
+
+double MotionPrimitive::d(double t) const
+{
+  return poly(d_coef, t);
+}
+
+/*
+ * Initialize MotionPrimitiveLibrary
+ */
+
+MotionPrimitiveLibrary::MotionPrimitiveLibrary()
+{
+  map_ = nullptr;
+  map_len_ = 0;
+  header_ = nullptr;
+  prims_ = nullptr;
+}
+
+
+MotionPrimitiveLibrary::~MotionPrimitiveLibrary()
+{
+  close();
+}
+
+
+bool MotionPrimitiveLibrary::open(const string &file)
+{
+  close();
+
+  int fd = ::open(file.c_str(), O_RDONLY);
+  if(fd < 0)
+    return false;
+  struct stat st;
+  if(fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(MotionPrimitiveHeader))
+  {
+    ::close(fd);
+    return false;
+  }
+
+  void *map = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  // the mapping stays valid after the file is closed
+  ::close(fd);
+  if(map == MAP_FAILED)
+    return false;
+
+  const MotionPrimitiveHeader *h = (const MotionPrimitiveHeader *)map;
+  size_t count = (size_t)h->n_v0 * h->n_v1 * h->n_offset * h->n_horizon;
+  if(memcmp(h->magic, "PRIM", 4) != 0 || h->version != 1 ||
+     h->n_v0 <= 0 || h->n_v1 <= 0 || h->n_offset <= 0 || h->n_horizon <= 0 ||
+     (size_t)st.st_size != sizeof(MotionPrimitiveHeader) + count * sizeof(MotionPrimitive))
+  {
+    munmap(map, st.st_size);
+    return false;
+  }
+
+  map_ = map;
+  map_len_ = st.st_size;
+  header_ = h;
+  prims_ = (const MotionPrimitive *)((const char *)map + sizeof(MotionPrimitiveHeader));
+  return true;
+}
+
+
+void MotionPrimitiveLibrary::close()
+{
+  if(map_)
+    munmap(map_, map_len_);
+  map_ = nullptr;
+  map_len_ = 0;
+  header_ = nullptr;
+  prims_ = nullptr;
+}
+
+
+int MotionPrimitiveLibrary::size() const
+{
+  if(!header_)
+    return 0;
+  return header_->n_v0 * header_->n_v1 * header_->n_offset * header_->n_horizon;
+}
+
+
+// nearest grid index of x, clamped to the grid
+static int grid_index(double x, float lo, float step, int n)
+{
+  int i = (int)lround((x - lo) / step);
+  return std::min(std::max(i, 0), n - 1);
+}
+
+
+const MotionPrimitive *MotionPrimitiveLibrary::lookup(double v0, double v1, double offset,
+                                                      double horizon) const
+{
+  if(!prims_)
+    return nullptr;
+
+  const MotionPrimitiveHeader &h = *header_;
+  int i0 = grid_index(v0, h.v0_min, h.v0_step, h.n_v0);
+  int i1 = grid_index(v1, h.v1_min, h.v1_step, h.n_v1);
+  int io = grid_index(offset, h.offset_min, h.offset_step, h.n_offset);
+  int ih = grid_index(horizon, h.horizon_min, h.horizon_step, h.n_horizon);
+
+  return &prims_[((i0 * h.n_v1 + i1) * h.n_offset + io) * h.n_horizon + ih];
+}
+
+
+const MotionPrimitive *MotionPrimitiveLibrary::shortest(double v0, double v1, double offset,
+                                                        double *horizon) const
+{
+  if(!prims_)
+    return nullptr;
+
+  const MotionPrimitiveHeader &h = *header_;
+  for(int ih = 0; ih < h.n_horizon; ++ih)
+  {
+    double T = h.horizon_min + ih * h.horizon_step;
+    const MotionPrimitive *p = lookup(v0, v1, offset, T);
+    if(p->feasible)
+    {
+      *horizon = T;
+      return p;
+    }
+  }
+
+  return nullptr;
+}
+
+
+bool LaneChangePrimitive::start(const MotionPrimitiveLibrary &lib, double v, double d0,
+                                double target_d, double change_time)
+{
+  prim = nullptr;
+  double offset = target_d - d0;
+  double T = change_time;
+  const MotionPrimitive *p = lib.lookup(v, v, offset, T);
+  if(p && !p->feasible)
+    p = lib.shortest(v, v, offset, &T);
+  // the offset grid has to be on the same side, a lane keep can't be scaled
+  double full = p ? p->d(T) : 0.;
+  if(!p || full * offset <= 0. || fabs(full) < 0.5)
+    return false;
+
+  prim = p;
+  this->d0 = d0;
+  this->target_d = target_d;
+  scale = offset / full;
+  horizon = T;
+  t_end = 0.;
+  return true;
+}
+
+
+double LaneChangePrimitive::lateral(double *c) const
+{
+  // Taylor shift of the primitive to t_end: c[k] = sum_i d_coef[i] C(i,k) t_end^(i-k)
+  for(int k = 0; k < 6; ++k)
+  {
+    double sum = 0.;
+    double binom = 1.;  // C(i,k) for i = k
+    double power = 1.;  // t_end^(i-k)
+    for(int i = k; i < 6; ++i)
+    {
+      sum += prim->d_coef[i] * binom * power;
+      binom = binom * (i + 1) / (i + 1 - k);
+      power *= t_end;
+    }
+    c[k] = scale * sum;
+  }
+  c[0] += d0;
+
+  return std::max(horizon - t_end, 0.);
+}
+
+
+void LaneChangePrimitive::advance(double dt)
+{
+  t_end = std::max(t_end + dt, 0.);
+  if(t_end >= horizon)
+    prim = nullptr;
+}
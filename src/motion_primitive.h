@@ -0,0 +1,121 @@
+#ifndef MOTION_PRIMITIVE_H
+#define MOTION_PRIMITIVE_H
+#include <cstdint>
+#include <string>
+
+using std::string;
+
+/*
+ * A lane-keep or lane-change maneuver in frenet coordination on a straight
+ * road: s(t) and d(t) are quintic polynomials of minimum jerk, s going
+ * from speed v0 to v1 and d moving by `offset` in `horizon` seconds, both
+ * starting and ending without acceleration. The peaks are precomputed by
+ * tools/primitive_gen, so the planner never fits a curve online.
+ */
+struct MotionPrimitive
+{
+  float s_coef[6];      // s(t) = sum s_coef[i] t^i, s(0) = 0
+  float d_coef[6];      // d(t) relative to the start
+  float peak_lon_acc;   // [m/s^2]
+  float peak_lat_acc;   // [m/s^2]
+  float peak_acc;       // total [m/s^2]
+  float peak_jerk;      // total [m/s^3]
+  int32_t feasible;     // within the acceleration and jerk limits
+
+  // position at time t of the primitive
+  double s(double t) const;
+  double d(double t) const;
+};
+
+// minimum-jerk quintic from (p0, v0, a0) to (p1, v1, a1) in T seconds, c[i] of t^i
+void min_jerk_quintic(double p0, double v0, double a0, double p1, double v1, double a1,
+                      double T, double *c);
+
+/*
+ * Layout of a primitive file: this header, then the primitives ordered by
+ * v0, v1, offset and horizon, horizon being the fastest changing index.
+ */
+struct MotionPrimitiveHeader
+{
+  char magic[4];  // "PRIM"
+  int32_t version;
+  int32_t n_v0, n_v1, n_offset, n_horizon;
+  float v0_min, v0_step;
+  float v1_min, v1_step;
+  float offset_min, offset_step;
+  float horizon_min, horizon_step;
+  float max_acc, max_jerk;  // limits the feasibility was checked against
+};
+
+/*
+ * Read-only view of a primitive file.
+ *
+ * The file is mapped into memory once at startup and never copied, a
+ * lookup rounds the query onto the grid and is a single index.
+ */
+class MotionPrimitiveLibrary
+{
+public:
+  /*
+   * Constructor
+   */
+  MotionPrimitiveLibrary();
+  ~MotionPrimitiveLibrary();
+
+  // map the file, returns false and stays empty if it doesn't fit
+  bool open(const string &file);
+  void close();
+
+  bool loaded() const { return prims_ != nullptr; }
+  int size() const;
+  const MotionPrimitiveHeader &header() const { return *header_; }
+
+  // nearest primitive on the grid, nullptr if nothing is loaded
+  const MotionPrimitive *lookup(double v0, double v1, double offset, double horizon) const;
+
+  // feasible primitive of the shortest horizon, nullptr if there is none
+  const MotionPrimitive *shortest(double v0, double v1, double offset, double *horizon) const;
+
+private:
+  void *map_;
+  size_t map_len_;
+  const MotionPrimitiveHeader *header_;
+  const MotionPrimitive *prims_;
+};
+
+/*
+ * A lane change which follows one primitive of the library across frames.
+ *
+ * start() takes the primitive of the offset and scales it to end exactly
+ * at the target. Every frame lateral() gives d(t) from the end of the kept
+ * path on as quintic coefficients: the primitive shifted by the time
+ * already sent, so the new points continue the ones before without a
+ * fit. advance() moves that time on by the points sent.
+ */
+struct LaneChangePrimitive
+{
+  const MotionPrimitive *prim;  // nullptr when no lane change follows a primitive
+  double d0;        // d where the lane change started
+  double target_d;  // d where it ends
+  double scale;     // wanted offset over the offset of the primitive
+  double horizon;   // duration of the lane change [s]
+  double t_end;     // time into the primitive at the end of the kept path [s]
+
+  LaneChangePrimitive() : prim(nullptr), d0(0.), target_d(0.), scale(1.), horizon(0.), t_end(0.) {}
+
+  /*
+   * Start a lane change from d0 to target_d at speed v, taking `change_time`
+   * seconds if that primitive is feasible and the quickest feasible one
+   * otherwise. Returns false and stays inactive without one.
+   */
+  bool start(const MotionPrimitiveLibrary &lib, double v, double d0, double target_d,
+             double change_time);
+
+  // coefficients c[i] of t^i of d from the end of the kept path, returns the time left
+  double lateral(double *c) const;
+
+  // the path end moved by dt seconds, drops the primitive once it is done
+  void advance(double dt);
+};
+
+#endif
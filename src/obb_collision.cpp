@@ -0,0 +1,300 @@
+#include <algorithm>
+#include <math.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include "obb_collision.h"
+
+/*
+ * Initialize ObbCollision
+ */
+
+ObbCollision::ObbCollision(int num_steps, double dt, int max_obstacles,
+                           double point_dt, float half_len, float half_wid)
+{
+  this->dt = dt;
+  this->point_dt = point_dt;
+  this->half_len = half_len;
+  this->half_wid = half_wid;
+  this->max_obstacles_ = max_obstacles;
+  // the corner of a box is the farthest point from its center in any direction
+  this->max_extent_ = sqrtf(half_len * half_len + half_wid * half_wid);
+
+  // allocate everything once, checks should not touch the heap
+  steps_.resize(num_steps);
+  for(auto &st : steps_)
+  {
+    st.cx.resize(max_obstacles);
+    st.cy.resize(max_obstacles);
+    st.ux.resize(max_obstacles);
+    st.uy.resize(max_obstacles);
+    st.min_x.resize(max_obstacles);
+    st.max_x.resize(max_obstacles);
+    st.min_y.resize(max_obstacles);
+    st.max_y.resize(max_obstacles);
+    st.size = 0;
+  }
+  veh_x_.reserve(max_obstacles);
+  veh_y_.reserve(max_obstacles);
+  veh_vx_.reserve(max_obstacles);
+  veh_vy_.reserve(max_obstacles);
+  keys_.resize(max_obstacles);
+  order_.resize(max_obstacles);
+}
+
+
+void ObbCollision::reset()
+{
+  veh_x_.clear();
+  veh_y_.clear();
+  veh_vx_.clear();
+  veh_vy_.clear();
+  for(auto &st : steps_)
+    st.size = 0;
+}
+
+
+void ObbCollision::add_vehicle(double x, double y, double vx, double vy)
+{
+  if((int)veh_x_.size() >= max_obstacles_)
+    return;
+
+  veh_x_.push_back(x);
+  veh_y_.push_back(y);
+  veh_vx_.push_back(vx);
+  veh_vy_.push_back(vy);
+}
+
+
+float ObbCollision::extent_x(float vx, float vy) const
+{
+  float speed = sqrtf(vx * vx + vy * vy);
+  if(speed <= 1e-3f)
+    return half_len;
+  return (half_len * fabsf(vx) + half_wid * fabsf(vy)) / speed;
+}
+
+
+void ObbCollision::prepare()
+{
+  int n = veh_x_.size();
+  for(int t = 0; t < (int)steps_.size(); ++t)
+  {
+    Step &st = steps_[t];
+    float time = t * dt;
+
+    // sort the cars by the lowest x of their bounding box at this step
+    for(int i = 0; i < n; ++i)
+    {
+      keys_[i] = veh_x_[i] + veh_vx_[i] * time - extent_x(veh_vx_[i], veh_vy_[i]);
+      order_[i] = i;
+    }
+    std::sort(order_.begin(), order_.begin() + n,
+              [this](int a, int b) { return keys_[a] < keys_[b]; });
+
+    for(int j = 0; j < n; ++j)
+    {
+      int i = order_[j];
+      float cx = veh_x_[i] + veh_vx_[i] * time;
+      float cy = veh_y_[i] + veh_vy_[i] * time;
+      float speed = sqrtf(veh_vx_[i] * veh_vx_[i] + veh_vy_[i] * veh_vy_[i]);
+      // a car standing still keeps the heading of the x axis
+      float ux = speed > 1e-3f ? veh_vx_[i] / speed : 1.f;
+      float uy = speed > 1e-3f ? veh_vy_[i] / speed : 0.f;
+      float ex = half_len * fabsf(ux) + half_wid * fabsf(uy);
+      float ey = half_len * fabsf(uy) + half_wid * fabsf(ux);
+
+      st.cx[j] = cx;
+      st.cy[j] = cy;
+      st.ux[j] = ux;
+      st.uy[j] = uy;
+      st.min_x[j] = cx - ex;
+      st.max_x[j] = cx + ex;
+      st.min_y[j] = cy - ey;
+      st.max_y[j] = cy + ey;
+    }
+    st.size = n;
+  }
+}
+
+
+template<typename T>
+ObbCollision::EgoBox ObbCollision::ego_box(const T *x, const T *y, int n_points, int k) const
+{
+  // heading of the car follows the path from one point to the next
+  int k0 = (k + 1 < n_points) ? k : k - 1;
+  float hx = x[k0 + 1] - x[k0];
+  float hy = y[k0 + 1] - y[k0];
+  float norm = sqrtf(hx * hx + hy * hy);
+
+  EgoBox e;
+  e.cx = x[k];
+  e.cy = y[k];
+  e.ux = norm > 1e-6f ? hx / norm : 1.f;
+  e.uy = norm > 1e-6f ? hy / norm : 0.f;
+  float ex = half_len * fabsf(e.ux) + half_wid * fabsf(e.uy);
+  float ey = half_len * fabsf(e.uy) + half_wid * fabsf(e.ux);
+  e.min_x = e.cx - ex;
+  e.max_x = e.cx + ex;
+  e.min_y = e.cy - ey;
+  e.max_y = e.cy + ey;
+  e.cand = 0;
+
+  return e;
+}
+
+
+bool ObbCollision::sat_any(const EgoBox &e, const Step &st, int begin, int end) const
+{
+  // all cars share the same size, so with c = cos and s = sin of the angle
+  // between both boxes the four separating axes reduce to:
+  //   ego heading / other heading : |d.u| > hl + hl*|c| + hw*|s|
+  //   ego normal  / other normal  : |d.v| > hw + hl*|s| + hw*|c|
+  const float hl = half_len;
+  const float hw = half_wid;
+  int i = begin;
+
+#ifdef __SSE2__
+  const __m128 sign = _mm_set1_ps(-0.f);
+  const __m128 ecx = _mm_set1_ps(e.cx), ecy = _mm_set1_ps(e.cy);
+  const __m128 eux = _mm_set1_ps(e.ux), euy = _mm_set1_ps(e.uy);
+  const __m128 vhl = _mm_set1_ps(hl), vhw = _mm_set1_ps(hw);
+  const __m128 emin_x = _mm_set1_ps(e.min_x), emin_y = _mm_set1_ps(e.min_y);
+  const __m128 emax_y = _mm_set1_ps(e.max_y);
+  for(; i + 4 <= end; i += 4)
+  {
+    // the sweep only ordered the boxes by min_x, reject the ones apart along y first
+    __m128 apart = _mm_or_ps(_mm_cmplt_ps(_mm_loadu_ps(&st.max_x[i]), emin_x),
+                             _mm_or_ps(_mm_cmplt_ps(_mm_loadu_ps(&st.max_y[i]), emin_y),
+                                       _mm_cmpgt_ps(_mm_loadu_ps(&st.min_y[i]), emax_y)));
+    if(_mm_movemask_ps(apart) == 0xF)
+      continue;
+
+    __m128 dx = _mm_sub_ps(_mm_loadu_ps(&st.cx[i]), ecx);
+    __m128 dy = _mm_sub_ps(_mm_loadu_ps(&st.cy[i]), ecy);
+    __m128 oux = _mm_loadu_ps(&st.ux[i]);
+    __m128 ouy = _mm_loadu_ps(&st.uy[i]);
+
+    __m128 c = _mm_andnot_ps(sign, _mm_add_ps(_mm_mul_ps(eux, oux), _mm_mul_ps(euy, ouy)));
+    __m128 s = _mm_andnot_ps(sign, _mm_sub_ps(_mm_mul_ps(eux, ouy), _mm_mul_ps(euy, oux)));
+    __m128 r_u = _mm_add_ps(vhl, _mm_add_ps(_mm_mul_ps(vhl, c), _mm_mul_ps(vhw, s)));
+    __m128 r_v = _mm_add_ps(vhw, _mm_add_ps(_mm_mul_ps(vhl, s), _mm_mul_ps(vhw, c)));
+
+    __m128 d_eu = _mm_andnot_ps(sign, _mm_add_ps(_mm_mul_ps(dx, eux), _mm_mul_ps(dy, euy)));
+    __m128 d_ev = _mm_andnot_ps(sign, _mm_sub_ps(_mm_mul_ps(dy, eux), _mm_mul_ps(dx, euy)));
+    __m128 d_ou = _mm_andnot_ps(sign, _mm_add_ps(_mm_mul_ps(dx, oux), _mm_mul_ps(dy, ouy)));
+    __m128 d_ov = _mm_andnot_ps(sign, _mm_sub_ps(_mm_mul_ps(dy, oux), _mm_mul_ps(dx, ouy)));
+
+    __m128 sep = _mm_or_ps(_mm_or_ps(_mm_cmpgt_ps(d_eu, r_u), _mm_cmpgt_ps(d_ev, r_v)),
+                           _mm_or_ps(_mm_cmpgt_ps(d_ou, r_u), _mm_cmpgt_ps(d_ov, r_v)));
+    sep = _mm_or_ps(sep, apart);
+    // any lane without a separating axis is a collision
+    if(_mm_movemask_ps(sep) != 0xF)
+      return true;
+  }
+#endif
+
+  for(; i < end; ++i)
+  {
+    if(st.max_x[i] < e.min_x || st.max_y[i] < e.min_y || st.min_y[i] > e.max_y)
+      continue;
+    float dx = st.cx[i] - e.cx;
+    float dy = st.cy[i] - e.cy;
+    float c = fabsf(e.ux * st.ux[i] + e.uy * st.uy[i]);
+    float s = fabsf(e.ux * st.uy[i] - e.uy * st.ux[i]);
+    float r_u = hl + hl * c + hw * s;
+    float r_v = hw + hl * s + hw * c;
+
+    if(fabsf(dx * e.ux + dy * e.uy) > r_u)
+      continue;
+    if(fabsf(dy * e.ux - dx * e.uy) > r_v)
+      continue;
+    if(fabsf(dx * st.ux[i] + dy * st.uy[i]) > r_u)
+      continue;
+    if(fabsf(dy * st.ux[i] - dx * st.uy[i]) > r_v)
+      continue;
+    return true;
+  }
+
+  return false;
+}
+
+
+bool ObbCollision::hit_step(const EgoBox &e, int t, int first) const
+{
+  const Step &st = steps_[t];
+  int last = first;
+  while(last < st.size && st.min_x[last] <= e.max_x)
+    ++last;
+
+  return last > first && sat_any(e, st, first, last);
+}
+
+
+int ObbCollision::first_collision(const double *x, const double *y, int n_points) const
+{
+  // path point k is reached after (k+1) * point_dt seconds
+  int stride = std::max((int)lround(dt / point_dt), 1);
+  for(int t = 1; t < (int)steps_.size(); ++t)
+  {
+    int k = t * stride - 1;
+    if(k >= n_points)
+      break;
+
+    const Step &st = steps_[t];
+    EgoBox e = ego_box(x, y, n_points, k);
+    // jump to the first car that could reach the ego box along x
+    int first = std::lower_bound(st.min_x.begin(), st.min_x.begin() + st.size,
+                                 e.min_x - 2 * max_extent_) - st.min_x.begin();
+    if(hit_step(e, t, first))
+      return k;
+  }
+
+  return -1;
+}
+
+
+void ObbCollision::check_batch(const double *x, const double *y, int n_points,
+                               const int *cands, int n_cands, int *first_hit)
+{
+  for(int i = 0; i < n_cands; ++i)
+    first_hit[cands[i]] = -1;
+  if((int)ego_.size() < n_cands)
+    ego_.resize(n_cands);
+
+  int stride = std::max((int)lround(dt / point_dt), 1);
+  for(int t = 1; t < (int)steps_.size(); ++t)
+  {
+    int k = t * stride - 1;
+    if(k >= n_points)
+      break;
+
+    // collect the boxes of all candidates which are still free at this step
+    int n = 0;
+    for(int i = 0; i < n_cands; ++i)
+    {
+      int c = cands[i];
+      if(first_hit[c] >= 0)
+        continue;
+      ego_[n] = ego_box(x + c * n_points, y + c * n_points, n_points, k);
+      ego_[n].cand = c;
+      ++n;
+    }
+    if(n == 0)
+      break;
+
+    // sweep both sorted lists together, the front of the obstacles only moves forward
+    std::sort(ego_.begin(), ego_.begin() + n,
+              [](const EgoBox &a, const EgoBox &b) { return a.min_x < b.min_x; });
+    const Step &st = steps_[t];
+    int first = 0;
+    for(int i = 0; i < n; ++i)
+    {
+      const EgoBox &e = ego_[i];
+      while(first < st.size && st.min_x[first] < e.min_x - 2 * max_extent_)
+        ++first;
+      if(hit_step(e, t, first))
+        first_hit[e.cand] = k;
+    }
+  }
+}
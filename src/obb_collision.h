@@ -0,0 +1,100 @@
+#ifndef OBB_COLLISION_H
+#define OBB_COLLISION_H
+#include <vector>
+
+using std::vector;
+
+/*
+ * Collision checker in Cartesian space with oriented bounding boxes.
+ *
+ * Frenet intervals get inaccurate in curves and while changing lanes, so
+ * this checker works on the (x,y) path we send to the simulator. Predicted
+ * cars are stored per time step as boxes sorted by their lowest x
+ * (sort-and-sweep broad phase). Boxes that survive the sweep and overlap
+ * the ego box along y are tested with the separating axis theorem, four
+ * obstacles at a time with SSE.
+ */
+class ObbCollision
+{
+public:
+  double dt;       // time between two obstacle steps [s]
+  double point_dt; // time between two path points [s]
+  float half_len;  // half size of a car
+  float half_wid;
+
+  /*
+   * Constructor
+   */
+  ObbCollision(int num_steps=30, double dt=0.1, int max_obstacles=256,
+               double point_dt=0.02, float half_len=2.5, float half_wid=1.1);
+
+  // remove all obstacles
+  void reset();
+
+  // add a car at (x, y) moving with (vx, vy), predicted with constant velocity
+  void add_vehicle(double x, double y, double vx, double vy);
+
+  // sort the obstacles of every step, must be called before any check
+  void prepare();
+
+  // number of time steps the obstacles are predicted for
+  int num_steps() const { return (int)steps_.size(); }
+
+  /*
+   * Check one path of (x,y) points sent every point_dt seconds.
+   * Returns the index of the first colliding point, or -1 if the path is free.
+   */
+  int first_collision(const double *x, const double *y, int n_points) const;
+
+  /*
+   * Check the candidates listed in cands of a batch of paths stored
+   * candidate by candidate (x[c * n_points + k]). Writes the first
+   * colliding point index or -1 of candidate c into first_hit[c]. All
+   * candidates are swept against the obstacles together, one time step
+   * after another.
+   */
+  void check_batch(const double *x, const double *y, int n_points,
+                   const int *cands, int n_cands, int *first_hit);
+
+private:
+  // oriented boxes of one time step in SoA form, sorted by min_x
+  struct Step
+  {
+    vector<float> cx, cy, ux, uy, min_x, max_x, min_y, max_y;
+    int size;
+  };
+
+  // oriented box of the ego car at one path point
+  struct EgoBox
+  {
+    float cx, cy, ux, uy;
+    float min_x, max_x, min_y, max_y;
+    int cand;
+  };
+
+  int max_obstacles_;
+  float max_extent_;   // largest half extent of a box along x or y
+  vector<Step> steps_;
+  // scratch buffers reused across calls
+  vector<EgoBox> ego_;
+  vector<int> order_;
+  vector<float> keys_;
+
+  // raw state of the cars added since the last reset
+  vector<float> veh_x_, veh_y_, veh_vx_, veh_vy_;
+
+  // half extent along x of a car box heading along (vx, vy)
+  float extent_x(float vx, float vy) const;
+
+  // build the ego box at point k of a path
+  template<typename T>
+  EgoBox ego_box(const T *x, const T *y, int n_points, int k) const;
+
+  // sweep the ego box against the obstacles of step t, starting at index first
+  bool hit_step(const EgoBox &e, int t, int first) const;
+
+  // separating axis test of the ego box against obstacles [begin, end) of a step
+  bool sat_any(const EgoBox &e, const Step &st, int begin, int end) const;
+};
+
+#endif
@@ -0,0 +1,150 @@
+#include <algorithm>
+#include <math.h>
+#include "occupancy.h"
+
+/*
+ * Initialize FrenetOccupancy
+ */
+
+FrenetOccupancy::FrenetOccupancy(double max_s, int num_lanes, int num_steps, double dt,
+                                 int num_cells, double cell_len, double lane_width)
+{
+  this->max_s = max_s;
+  this->num_lanes = num_lanes;
+  this->num_steps = num_steps;
+  this->dt = dt;
+  this->cell_len = cell_len;
+  this->lane_width = lane_width;
+
+  // round up the row to whole 64-bit words
+  this->words_ = (num_cells + 63) / 64;
+  // a quarter of the window is kept behind the origin for cars coming from back
+  this->behind = 0.25 * words_ * 64 * cell_len;
+  this->origin_s_ = 0.;
+  this->bits_.assign(num_steps * num_lanes * words_, 0);
+}
+
+
+void FrenetOccupancy::reset(double origin_s)
+{
+  origin_s_ = origin_s;
+  std::fill(bits_.begin(), bits_.end(), 0);
+}
+
+
+double FrenetOccupancy::to_cell(double s) const
+{
+  // handle wraparound at max_s, take the shortest way to the origin
+  double ds = fmod(s - origin_s_, max_s);
+  if(ds >= 0.5 * max_s)
+    ds -= max_s;
+  else if(ds < -0.5 * max_s)
+    ds += max_s;
+
+  return (ds + behind) / cell_len;
+}
+
+
+void FrenetOccupancy::add_vehicle(double s, double d, double vs, double half_len)
+{
+  for(int t = 0; t < num_steps; ++t)
+    mark_car(t, s + vs * t * dt, d, half_len);
+}
+
+
+void FrenetOccupancy::add_prediction(const Prediction &pred, double half_len)
+{
+  int stride = std::max((int)lround(dt / pred.dt), 1);
+  for(int t = 0; t < num_steps && t * stride < pred.num_steps; ++t)
+  {
+    const double *s = pred.s_at(t * stride);
+    const double *d = pred.d_at(t * stride);
+    for(int i = 0; i < pred.size; ++i)
+      mark_car(t, s[i], d[i], half_len);
+  }
+}
+
+
+void FrenetOccupancy::mark_car(int t, double s, double d, double half_len)
+{
+  // a car body is about 2 m wide, it could cover two lanes while changing lane
+  int ln_lo = std::max((int)floor((d - 1.0) / lane_width), 0);
+  int ln_hi = std::min((int)floor((d + 1.0) / lane_width), num_lanes - 1);
+
+  for(int ln = ln_lo; ln <= ln_hi; ++ln)
+    mark(t, ln, s - half_len, s + half_len);
+}
+
+
+void FrenetOccupancy::mark(int t, int ln, double s_lo, double s_hi)
+{
+  int n_cells = words_ * 64;
+  double c_lo = to_cell(s_lo);
+  // keep the interval contiguous even if it crosses max_s
+  double c_hi = c_lo + (s_hi - s_lo) / cell_len;
+  if(c_hi < 0 || c_lo >= n_cells)
+    return;
+
+  int lo = std::max((int)floor(c_lo), 0);
+  int hi = std::min((int)floor(c_hi), n_cells - 1);
+
+  uint64_t *r = row(t, ln);
+  for(int w = lo / 64; w <= hi / 64; ++w)
+  {
+    uint64_t mask = ~0ULL;
+    if(w == lo / 64)
+      mask &= ~0ULL << (lo % 64);
+    if(w == hi / 64)
+      mask &= ~0ULL >> (63 - hi % 64);
+    r[w] |= mask;
+  }
+}
+
+
+bool FrenetOccupancy::occupied(int t, int ln, double s_lo, double s_hi) const
+{
+  if(t < 0 || t >= num_steps || ln < 0 || ln >= num_lanes)
+    return false;
+
+  int n_cells = words_ * 64;
+  double c_lo = to_cell(s_lo);
+  double c_hi = c_lo + (s_hi - s_lo) / cell_len;
+  if(c_hi < 0 || c_lo >= n_cells)
+    return false;
+
+  int lo = std::max((int)floor(c_lo), 0);
+  int hi = std::min((int)floor(c_hi), n_cells - 1);
+
+  const uint64_t *r = row(t, ln);
+  uint64_t hit = 0;
+  for(int w = lo / 64; w <= hi / 64; ++w)
+  {
+    uint64_t mask = ~0ULL;
+    if(w == lo / 64)
+      mask &= ~0ULL << (lo % 64);
+    if(w == hi / 64)
+      mask &= ~0ULL >> (63 - hi % 64);
+    hit |= r[w] & mask;
+  }
+
+  return hit != 0;
+}
+
+
+int FrenetOccupancy::first_collision(const double *s, const double *d, int n_steps,
+                                     double half_len, double half_width) const
+{
+  n_steps = std::min(n_steps, num_steps);
+  for(int t = 0; t < n_steps; ++t)
+  {
+    int ln_lo = std::max((int)floor((d[t] - half_width) / lane_width), 0);
+    int ln_hi = std::min((int)floor((d[t] + half_width) / lane_width), num_lanes - 1);
+    for(int ln = ln_lo; ln <= ln_hi; ++ln)
+    {
+      if(occupied(t, ln, s[t] - half_len, s[t] + half_len))
+        return t;
+    }
+  }
+
+  return -1;
+}
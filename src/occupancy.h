@@ -0,0 +1,74 @@
+#ifndef OCCUPANCY_H
+#define OCCUPANCY_H
+#include <cstdint>
+#include <vector>
+#include "prediction.h"
+
+using std::vector;
+
+/*
+ * Time-indexed occupancy of the road in Frenet coordinates.
+ *
+ * The road around the ego car is cut into s-cells of `cell_len` meters for
+ * each lane and each time step of `dt` seconds. Every cell is one bit, so a
+ * (time, lane) row is a few 64-bit words and checking an ego footprint
+ * against all predicted vehicles is a handful of AND operations per step.
+ */
+class FrenetOccupancy
+{
+public:
+  double max_s;     // length of the track before s wraps around
+  double cell_len;  // length of one s-cell [m]
+  double dt;        // time between two steps [s]
+  double behind;    // how far behind the window origin is covered [m]
+  int num_lanes;
+  int num_steps;
+  double lane_width;
+
+  /*
+   * Constructor
+   */
+  FrenetOccupancy(double max_s, int num_lanes=3, int num_steps=30, double dt=0.1,
+                  int num_cells=256, double cell_len=1.0, double lane_width=4.);
+
+  // clear all cells and put the window origin at s = origin_s
+  void reset(double origin_s);
+
+  // mark a vehicle moving at constant speed vs along s, staying at distance d
+  void add_vehicle(double s, double d, double vs, double half_len=2.5);
+
+  // mark all cars of a prediction, its steps are resampled to the occupancy steps
+  void add_prediction(const Prediction &pred, double half_len=2.5);
+
+  // mark the interval [s_lo, s_hi] of lane ln as occupied at step t
+  void mark(int t, int ln, double s_lo, double s_hi);
+
+  // check whether the interval [s_lo, s_hi] of lane ln is occupied at step t
+  bool occupied(int t, int ln, double s_lo, double s_hi) const;
+
+  /*
+   * Check a candidate ego trajectory sampled at every step (s[t], d[t]).
+   * The ego footprint covers every lane the car body overlaps, so a car
+   * straddling two lanes during a lane change is checked against both.
+   * Returns the first colliding step, or -1 if the trajectory is free.
+   */
+  int first_collision(const double *s, const double *d, int n_steps,
+                      double half_len=2.5, double half_width=1.0) const;
+
+private:
+  int words_;       // number of 64-bit words per (time, lane) row
+  double origin_s_; // s value of the first cell
+  vector<uint64_t> bits_;
+
+  // mark a car body at (s, d) at step t in every lane it overlaps
+  void mark_car(int t, double s, double d, double half_len);
+
+  // convert s into a cell index relative to the window origin
+  double to_cell(double s) const;
+
+  // get the first word of row (t, ln)
+  uint64_t *row(int t, int ln) { return &bits_[(t * num_lanes + ln) * words_]; }
+  const uint64_t *row(int t, int ln) const { return &bits_[(t * num_lanes + ln) * words_]; }
+};
+
+#endif
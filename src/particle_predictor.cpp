@@ -0,0 +1,285 @@
+#include <algorithm>
+#include <math.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include "particle_predictor.h"
+
+static int gcd(int a, int b)
+{
+  while(b != 0)
+  {
+    int r = a % b;
+    a = b;
+    b = r;
+  }
+  return a;
+}
+
+// inverse of the standard normal distribution by bisection, only used at startup
+static double normal_quantile(double p)
+{
+  double lo = -8., hi = 8.;
+  for(int i = 0; i < 60; ++i)
+  {
+    double mid = 0.5 * (lo + hi);
+    if(0.5 * erfc(-mid / sqrt(2.)) < p)
+      lo = mid;
+    else
+      hi = mid;
+  }
+  return 0.5 * (lo + hi);
+}
+
+/*
+ * Initialize ParticlePredictor
+ */
+
+ParticlePredictor::ParticlePredictor(double max_s, WorkerPool *pool, int capacity,
+                                     int num_particles, int num_steps, double dt,
+                                     int num_lanes, double lane_width, int num_cells,
+                                     double cell_len)
+{
+  this->max_s = max_s;
+  this->dt = dt;
+  this->cell_len = cell_len;
+  this->behind = 0.25 * num_cells * cell_len;
+  this->lane_width = lane_width;
+  this->sigma_acc = 1.5;
+  this->p_lane_change = 0.05;
+  this->change_time = 2.5;
+  this->num_particles = num_particles;
+  this->num_steps = num_steps;
+  this->num_lanes = num_lanes;
+  this->num_cells = num_cells;
+
+  pool_ = pool;
+  capacity_ = capacity;
+  size_ = 0;
+  stride_ = (num_particles + 3) / 4 * 4;
+  origin_s_ = 0.;
+  half_len_ = 2.5;
+  // about the golden share of the particles, a step coprime with them
+  // visits every stratum once
+  spread_ = std::max((int)lround(0.618 * num_particles), 1);
+  while(gcd(spread_, num_particles) != 1)
+    ++spread_;
+
+  // one particle per quantile stratum, the padding particles are never counted
+  quantile_.assign(stride_, 0.f);
+  for(int k = 0; k < num_particles; ++k)
+    quantile_[k] = normal_quantile((k + 0.5) / num_particles);
+
+  s_.assign(num_steps * capacity * stride_, 0.f);
+  d_.assign(num_steps * capacity * stride_, 0.f);
+  v_.assign(capacity * stride_, 0.f);
+  a_.assign(capacity * stride_, 0.f);
+  d0_.assign(capacity * stride_, 0.f);
+  dd_.assign(capacity * stride_, 0.f);
+  prob_.assign(num_steps * num_lanes * num_cells, 0.f);
+}
+
+
+double ParticlePredictor::to_cell(double s) const
+{
+  // handle wraparound at max_s, take the shortest way to the origin
+  double ds = fmod(s - origin_s_, max_s);
+  if(ds >= 0.5 * max_s)
+    ds -= max_s;
+  else if(ds < -0.5 * max_s)
+    ds += max_s;
+
+  return (ds + behind) / cell_len;
+}
+
+
+void ParticlePredictor::predict(const TrafficSnapshot &traffic, double origin_s, double half_len)
+{
+  origin_s_ = origin_s;
+  half_len_ = half_len;
+  size_ = std::min(traffic.size, capacity_);
+  std::fill(prob_.begin(), prob_.end(), 0.f);
+
+  auto propagate_cars = [this, &traffic](int begin, int end) { propagate(traffic, begin, end); };
+  auto count_steps = [this](int begin, int end) { count(begin, end); };
+  if(pool_)
+  {
+    pool_->run(size_, 8, propagate_cars);
+    pool_->run(num_steps, 2, count_steps);
+  }
+  else
+  {
+    propagate_cars(0, size_);
+    count_steps(0, num_steps);
+  }
+}
+
+
+void ParticlePredictor::propagate(const TrafficSnapshot &traffic, int begin, int end)
+{
+  int K = num_particles;
+  double logit_change = log(p_lane_change / (1. - p_lane_change));
+  for(int i = begin; i < end; ++i)
+  {
+    float *v = &v_[i * stride_];
+    float *a = &a_[i * stride_];
+    float *d0 = &d0_[i * stride_];
+    float *dd = &dd_[i * stride_];
+
+    // a car drifting to one side is more likely to change lane that way: the
+    // chance to each side is logistic in the lanes the car would cross over a
+    // lane change at its lateral speed, p_lane_change without lateral motion
+    int ln = std::min(std::max((int)floor(traffic.d[i] / lane_width), 0), num_lanes - 1);
+    double drift = traffic.vd[i] * change_time / lane_width;
+    double p_left = (ln > 0) ? 1. / (1. + exp(-(logit_change - 6. * drift))) : 0.;
+    double p_right = (ln < num_lanes - 1) ? 1. / (1. + exp(-(logit_change + 6. * drift))) : 0.;
+    int n_left = std::min((int)lround(p_left * K), K);
+    int n_right = std::min((int)lround(p_right * K), K - n_left);
+    double center = (ln + 0.5) * lane_width;
+
+    for(int k = 0; k < stride_; ++k)
+    {
+      v[k] = traffic.vs[i];
+      a[k] = traffic.as[i] + sigma_acc * quantile_[k];
+      d0[k] = traffic.d[i];
+      dd[k] = 0.f;
+    }
+    // spread the lane changes over the acceleration strata, the car id
+    // shifts them so not every car pairs a lane change with the same one
+    int shift = (traffic.id[i] * 7) % K;
+    for(int j = 0; j < n_left + n_right; ++j)
+    {
+      int k = (j * spread_ + shift) % K;
+      dd[k] = (j < n_left ? center - lane_width : center + lane_width) - traffic.d[i];
+    }
+
+    float *s0 = &s_[i * stride_];
+    float *dt0 = &d_[i * stride_];
+    float rel_s = traffic.rel_s[i];
+    for(int k = 0; k < stride_; ++k)
+    {
+      s0[k] = rel_s;
+      dt0[k] = d0[k];
+    }
+
+    float h = dt;
+    for(int t = 1; t < num_steps; ++t)
+    {
+      const float *sp = &s_[((t - 1) * capacity_ + i) * stride_];
+      float *sn = &s_[(t * capacity_ + i) * stride_];
+      float *dn = &d_[(t * capacity_ + i) * stride_];
+      // smooth lateral profile, the same for every particle at this step
+      float u = std::min(t * dt / change_time, 1.);
+      float w = u * u * (3.f - 2.f * u);
+      int k = 0;
+#ifdef __SSE2__
+      const __m128 vh = _mm_set1_ps(h), vw = _mm_set1_ps(w), zero = _mm_setzero_ps();
+      for(; k < stride_; k += 4)
+      {
+        __m128 vk = _mm_add_ps(_mm_loadu_ps(&v[k]), _mm_mul_ps(_mm_loadu_ps(&a[k]), vh));
+        vk = _mm_max_ps(vk, zero);  // cars brake to a stop, they don't back up
+        _mm_storeu_ps(&v[k], vk);
+        _mm_storeu_ps(&sn[k], _mm_add_ps(_mm_loadu_ps(&sp[k]), _mm_mul_ps(vk, vh)));
+        _mm_storeu_ps(&dn[k], _mm_add_ps(_mm_loadu_ps(&d0[k]), _mm_mul_ps(_mm_loadu_ps(&dd[k]), vw)));
+      }
+#endif
+      for(; k < stride_; ++k)
+      {
+        v[k] = std::max(v[k] + a[k] * h, 0.f);
+        sn[k] = sp[k] + v[k] * h;
+        dn[k] = d0[k] + dd[k] * w;
+      }
+    }
+  }
+}
+
+
+void ParticlePredictor::count(int t_begin, int t_end)
+{
+  float share = 1.f / num_particles;
+  float inv_len = 1.f / cell_len;
+  float cell_behind = behind / cell_len;
+  float half_cells = half_len_ / cell_len;
+  float inv_width = 1.f / lane_width;
+  // cells and lanes are floored by truncating from a positive offset,
+  // floorf is a library call on plain SSE2
+  const float off = 1024.f;
+  for(int t = t_begin; t < t_end; ++t)
+  {
+    float *grid = &prob_[t * num_lanes * num_cells];
+    for(int i = 0; i < size_; ++i)
+    {
+      const float *s = &s_[(t * capacity_ + i) * stride_];
+      const float *d = &d_[(t * capacity_ + i) * stride_];
+      for(int k = 0; k < num_particles; ++k)
+      {
+        float c = s[k] * inv_len + cell_behind;
+        int lo = std::max((int)(c - half_cells + off) - (int)off, 0);
+        int hi = std::min((int)(c + half_cells + off) - (int)off, num_cells - 1);
+        if(lo > hi)
+          continue;
+
+        // a car body is about 2 m wide, it could cover two lanes while changing lane
+        int ln_lo = std::max((int)((d[k] - 1.f) * inv_width + off) - (int)off, 0);
+        int ln_hi = std::min((int)((d[k] + 1.f) * inv_width + off) - (int)off, num_lanes - 1);
+        // the rows hold differences while counting, one add at each end of the body
+        for(int ln = ln_lo; ln <= ln_hi; ++ln)
+        {
+          float *row = grid + ln * num_cells;
+          row[lo] += share;
+          if(hi + 1 < num_cells)
+            row[hi + 1] -= share;
+        }
+      }
+    }
+
+    for(int ln = 0; ln < num_lanes; ++ln)
+    {
+      float *row = grid + ln * num_cells;
+      float p = 0.f;
+      for(int cell = 0; cell < num_cells; ++cell)
+      {
+        p += row[cell];
+        row[cell] = std::min(std::max(p, 0.f), 1.f);
+      }
+    }
+  }
+}
+
+
+double ParticlePredictor::probability(int t, int ln, double s_lo, double s_hi) const
+{
+  if(t < 0 || t >= num_steps || ln < 0 || ln >= num_lanes)
+    return 0.;
+
+  double c_lo = to_cell(s_lo);
+  double c_hi = c_lo + (s_hi - s_lo) / cell_len;
+  if(c_hi < 0 || c_lo >= num_cells)
+    return 0.;
+
+  int lo = std::max((int)floor(c_lo), 0);
+  int hi = std::min((int)floor(c_hi), num_cells - 1);
+  const float *row = &prob_[(t * num_lanes + ln) * num_cells];
+  float p = 0.f;
+  for(int cell = lo; cell <= hi; ++cell)
+    p = std::max(p, row[cell]);
+
+  return p;
+}
+
+
+double ParticlePredictor::path_risk(const double *s, const double *d, int n_steps,
+                                    double half_len, double half_width) const
+{
+  n_steps = std::min(n_steps, num_steps);
+  double risk = 0.;
+  for(int t = 0; t < n_steps; ++t)
+  {
+    int ln_lo = std::max((int)floor((d[t] - half_width) / lane_width), 0);
+    int ln_hi = std::min((int)floor((d[t] + half_width) / lane_width), num_lanes - 1);
+    for(int ln = ln_lo; ln <= ln_hi; ++ln)
+      risk = std::max(risk, probability(t, ln, s[t] - half_len, s[t] + half_len));
+  }
+
+  return risk;
+}
@@ -0,0 +1,83 @@
+#ifndef PARTICLE_PREDICTOR_H
+#define PARTICLE_PREDICTOR_H
+#include <vector>
+#include "traffic.h"
+#include "worker_pool.h"
+
+using std::vector;
+
+/*
+ * Monte Carlo prediction of the traffic as occupancy probabilities.
+ *
+ * Every car gets `num_particles` hypotheses: an acceleration drawn around
+ * its estimated one and, for some of them, a lane change to the left or
+ * right which is more likely when the car already moves that way (a
+ * logistic of its lateral speed over the lane width). The
+ * particles of a car sit next to each other in a float arena allocated
+ * once, so they are propagated 4 at a time with SSE2. The particles are
+ * then counted into a (time, lane, s-cell) grid like FrenetOccupancy, a
+ * cell holding the expected share of a car covering it, capped at 1.
+ *
+ * Accelerations use stratified normal quantiles instead of random draws,
+ * so the same scene always gives the same risk and few particles are
+ * enough. Propagation is split over the cars and counting over the time
+ * steps on the worker pool.
+ */
+class ParticlePredictor
+{
+public:
+  double max_s;         // length of the track before s wraps around
+  double dt;            // time between two steps [s]
+  double cell_len;      // length of one s-cell [m]
+  double behind;        // how far behind the origin the grid starts [m]
+  double lane_width;
+  double sigma_acc;     // spread of the acceleration around the estimate [m/s^2]
+  double p_lane_change; // chance of a lane change to each side without lateral motion
+  double change_time;   // duration of a lane change [s]
+  int num_particles;
+  int num_steps;
+  int num_lanes;
+  int num_cells;
+
+  /*
+   * Constructor, without a pool everything runs on the calling thread
+   */
+  ParticlePredictor(double max_s, WorkerPool *pool=nullptr, int capacity=256,
+                    int num_particles=64, int num_steps=30, double dt=0.1,
+                    int num_lanes=3, double lane_width=4., int num_cells=256,
+                    double cell_len=1.);
+
+  // sample, propagate and count the particles of every car of the snapshot
+  void predict(const TrafficSnapshot &traffic, double origin_s, double half_len=2.5);
+
+  // probability that the interval [s_lo, s_hi] of lane ln is taken at step t
+  double probability(int t, int ln, double s_lo, double s_hi) const;
+
+  /*
+   * Highest probability along an ego trajectory sampled at every step
+   * (s[t], d[t]), checking every lane the car body overlaps.
+   */
+  double path_risk(const double *s, const double *d, int n_steps,
+                   double half_len=2.5, double half_width=1.) const;
+
+private:
+  WorkerPool *pool_;
+  int capacity_;
+  int size_;
+  int stride_;        // particles per car, rounded up to whole SSE2 vectors
+  int spread_;        // step between the strata of lane changes, coprime with num_particles
+  double origin_s_;
+  double half_len_;
+
+  vector<float> quantile_;  // standard normal quantiles of the particles
+  vector<float> s_, d_;     // particle positions, (t * capacity + car) * stride + k
+  vector<float> v_, a_;     // particle speed and acceleration, car * stride + k
+  vector<float> d0_, dd_;   // start and total lateral move of every particle
+  vector<float> prob_;      // (t * num_lanes + ln) * num_cells + cell
+
+  void propagate(const TrafficSnapshot &traffic, int begin, int end);
+  void count(int t_begin, int t_end);
+  double to_cell(double s) const;
+};
+
+#endif
@@ -0,0 +1,99 @@
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <math.h>
+#include "planning_horizon.h"
+
+using namespace std;
+
+/*
+ * Initialize PlanningHorizon
+ */
+
+PlanningHorizon::PlanningHorizon(int min_points, int max_points, int min_period, int max_period,
+                                 double min_spacing, double max_spacing, double anchor_time,
+                                 double dense_range, int dense_cars)
+{
+  this->min_points = min_points;
+  this->max_points = max_points;
+  this->min_period = min_period;
+  this->max_period = max_period;
+  this->min_spacing = min_spacing;
+  this->max_spacing = max_spacing;
+  this->anchor_time = anchor_time;
+  this->dense_range = dense_range;
+  this->dense_cars = dense_cars;
+
+  // start as in dense traffic until the first frame is seen
+  this->density = 1.;
+  this->points = min_points;
+  this->period = min_period;
+  this->spacing = min_spacing;
+  this->since_replan_ = 0;
+}
+
+
+bool PlanningHorizon::load(const string &file)
+{
+  ifstream in(file.c_str(), ifstream::in);
+  if(!in.is_open())
+    return false;
+
+  string line;
+  while(getline(in, line))
+  {
+    istringstream iss(line);
+    string key;
+    double value;
+    if(!(iss >> key >> value) || key[0] == '#')
+      continue;
+
+    if(key == "min_points")
+      min_points = (int)value;
+    else if(key == "max_points")
+      max_points = (int)value;
+    else if(key == "min_period")
+      min_period = (int)value;
+    else if(key == "max_period")
+      max_period = (int)value;
+    else if(key == "min_spacing")
+      min_spacing = value;
+    else if(key == "max_spacing")
+      max_spacing = value;
+    else if(key == "anchor_time")
+      anchor_time = value;
+    else if(key == "dense_range")
+      dense_range = value;
+    else if(key == "dense_cars")
+      dense_cars = (int)value;
+  }
+
+  // the emitted path holds at most 256 points, a path needs two to anchor on
+  min_points = max(min(min_points, 250), 2);
+  max_points = max(min(max_points, 250), min_points);
+  min_period = max(min_period, 1);
+  max_period = max(max_period, min_period);
+  max_spacing = max(max_spacing, min_spacing);
+  dense_cars = max(dense_cars, 1);
+  return true;
+}
+
+
+void PlanningHorizon::update(double v, int n_cars)
+{
+  density = min((double)n_cars / dense_cars, 1.);
+  points = (int)lround(max_points - density * (max_points - min_points));
+  period = (int)lround(max_period - density * (max_period - min_period));
+  spacing = max(min(v * anchor_time, max_spacing), min_spacing);
+}
+
+
+bool PlanningHorizon::replan(int n_kept, bool force)
+{
+  // keep at least half of the path ahead of the car between two replans
+  if(!force && ++since_replan_ < period && 2 * n_kept >= points)
+    return false;
+
+  since_replan_ = 0;
+  return true;
+}
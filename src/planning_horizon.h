@@ -0,0 +1,61 @@
+#ifndef PLANNING_HORIZON_H
+#define PLANNING_HORIZON_H
+#include <string>
+
+using std::string;
+
+/*
+ * Length of the path, spacing of the spline anchors and how often the
+ * path is replanned, adapted to the speed and the traffic every frame.
+ *
+ * On an empty road the path is long and replanned rarely, the points in
+ * between are the ones already sent. The more cars around, the shorter
+ * the path and the more often it is replanned, so new decisions reach
+ * the car sooner. The anchors move apart with the speed to keep lane
+ * changes smooth. The limits are read from a "key value" file.
+ */
+class PlanningHorizon
+{
+public:
+  int min_points;         // path length in dense traffic
+  int max_points;         // path length on an empty road
+  int min_period;         // frames between two replans in dense traffic
+  int max_period;         // frames between two replans on an empty road
+  double min_spacing;     // anchor spacing at low speed [m]
+  double max_spacing;     // anchor spacing at high speed [m]
+  double anchor_time;     // time to drive from one anchor to the next [s]
+  double dense_range;     // cars within this distance count for the traffic [m]
+  int dense_cars;         // that many cars in range is dense traffic
+
+  // values of the current frame
+  int points;             // number of path points
+  int period;             // frames between two replans
+  double spacing;         // distance between two spline anchors [m]
+  double density;         // 0 for an empty road, 1 for dense traffic
+
+  /*
+   * Constructor
+   */
+  PlanningHorizon(int min_points=35, int max_points=90, int min_period=1, int max_period=5,
+                  double min_spacing=25., double max_spacing=40., double anchor_time=1.5,
+                  double dense_range=60., int dense_cars=6);
+
+  // read the limits from a "key value" file, keys not in the file keep their value
+  bool load(const string &file);
+
+  // adapt to the speed v [m/s] and the n_cars cars within dense_range
+  void update(double v, int n_cars);
+
+  /*
+   * Count a frame whose path still has n_kept points. Returns true if the
+   * path has to be replanned, because the period is over or the path got
+   * too short, and false if the points already sent can go out as they are.
+   * With force, e.g. for a car cutting in, the path is always replanned.
+   */
+  bool replan(int n_kept, bool force=false);
+
+private:
+  int since_replan_;  // frames since the last replan
+};
+
+#endif
@@ -0,0 +1,66 @@
+#include <algorithm>
+#include <math.h>
+#include "prediction.h"
+
+/*
+ * Initialize Prediction
+ */
+
+Prediction::Prediction(int capacity, int num_steps, double dt, MotionModel model)
+{
+  this->dt = dt;
+  this->num_steps = num_steps;
+  this->model = model;
+  this->min_d = 0.;
+  this->max_d = 12.;
+  this->size = 0;
+  this->capacity_ = capacity;
+
+  id.resize(capacity);
+  lane.resize(capacity);
+  s0_.resize(capacity);
+  vs0_.resize(capacity);
+  as0_.resize(capacity);
+  t_stop_.resize(capacity);
+  d0_.resize(capacity);
+  vd0_.resize(capacity);
+  s_.resize(num_steps * capacity);
+  d_.resize(num_steps * capacity);
+}
+
+
+void Prediction::predict(const TrafficSnapshot &traffic)
+{
+  int n = std::min(traffic.size, capacity_);
+  size = n;
+  bool use_acc = (model == CONSTANT_ACCELERATION);
+
+  for(int i = 0; i < n; ++i)
+  {
+    id[i] = traffic.id[i];
+    lane[i] = traffic.lane[i];
+    s0_[i] = traffic.s[i];
+    d0_[i] = traffic.d[i];
+    vs0_[i] = std::max(traffic.vs[i], 0.);
+    vd0_[i] = traffic.vd[i];
+    as0_[i] = use_acc ? traffic.as[i] : 0.;
+    // a braking car stops at -v/a and stays there
+    t_stop_[i] = (as0_[i] < 0) ? -vs0_[i] / as0_[i] : 1e9;
+  }
+
+  const double lo = min_d;
+  const double hi = max_d;
+  for(int t = 0; t < num_steps; ++t)
+  {
+    const double time = t * dt;
+    double *s = &s_[t * capacity_];
+    double *d = &d_[t * capacity_];
+    for(int i = 0; i < n; ++i)
+    {
+      double tt = time < t_stop_[i] ? time : t_stop_[i];
+      s[i] = s0_[i] + tt * (vs0_[i] + 0.5 * as0_[i] * tt);
+      double di = d0_[i] + vd0_[i] * time;
+      d[i] = di < lo ? lo : (di > hi ? hi : di);
+    }
+  }
+}
@@ -0,0 +1,66 @@
+#ifndef PREDICTION_H
+#define PREDICTION_H
+#include <vector>
+#include "traffic.h"
+
+using std::vector;
+
+enum MotionModel{
+  CONSTANT_VELOCITY = 0,
+  CONSTANT_ACCELERATION
+};
+
+/*
+ * Motion prediction of all cars of a traffic snapshot.
+ *
+ * Every car is propagated in frenet coordination over the whole horizon
+ * at the path step of 0.02 s. The result is time-major: the s of all cars
+ * at step t is one contiguous row, so each step is a straight loop over
+ * the cars which the compiler vectorizes, and collision checks read a
+ * whole time step at once. Along the road the car keeps its velocity or
+ * acceleration (it stops instead of driving backwards), across the road
+ * it keeps its velocity and stays on the road.
+ */
+class Prediction
+{
+public:
+  double dt;        // time between two steps [s]
+  int num_steps;    // steps of the horizon, step 0 is now
+  MotionModel model;
+  double min_d;     // the road across, cars are kept inside it
+  double max_d;
+  int size;         // number of predicted cars
+
+  vector<int> id;    // sensor fusion ID of car i
+  vector<int> lane;  // lane of car i now
+
+  /*
+   * Constructor
+   */
+  Prediction(int capacity=256, int num_steps=151, double dt=0.02,
+             MotionModel model=CONSTANT_ACCELERATION);
+
+  // predict every car of the snapshot
+  void predict(const TrafficSnapshot &traffic);
+
+  // s and d of all cars at step t, not wrapped at max_s
+  const double *s_at(int t) const { return &s_[t * capacity_]; }
+  const double *d_at(int t) const { return &d_[t * capacity_]; }
+
+  // writable rows of step t, for stages which refine the prediction
+  double *s_row(int t) { return &s_[t * capacity_]; }
+  double *d_row(int t) { return &d_[t * capacity_]; }
+
+  // predicted s along the road of car i at step t
+  double s(int t, int i) const { return s_[t * capacity_ + i]; }
+  double d(int t, int i) const { return d_[t * capacity_ + i]; }
+
+private:
+  int capacity_;
+  // state of every car now
+  vector<double> s0_, vs0_, as0_, t_stop_, d0_, vd0_;
+  // time-major predictions
+  vector<double> s_, d_;
+};
+
+#endif
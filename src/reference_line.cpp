@@ -0,0 +1,112 @@
+#include <algorithm>
+#include <math.h>
+#include "spline.h"
+#include "reference_line.h"
+
+/*
+ * Initialize ReferenceLine
+ */
+
+ReferenceLine::ReferenceLine(const vector<double> &maps_s, const vector<double> &maps_x,
+                             const vector<double> &maps_y, double max_s, double ds)
+{
+  this->max_s = max_s;
+  this->ds = ds;
+
+  // a few waypoints of the other end of the loop keep the splines smooth across max_s
+  int m = maps_s.size();
+  int k = std::min(3, m);
+  vector<double> ss, xs, ys;
+  for(int i = m - k; i < m; ++i)
+  {
+    ss.push_back(maps_s[i] - max_s);
+    xs.push_back(maps_x[i]);
+    ys.push_back(maps_y[i]);
+  }
+  for(int i = 0; i < m; ++i)
+  {
+    ss.push_back(maps_s[i]);
+    xs.push_back(maps_x[i]);
+    ys.push_back(maps_y[i]);
+  }
+  for(int i = 0; i < k; ++i)
+  {
+    ss.push_back(maps_s[i] + max_s);
+    xs.push_back(maps_x[i]);
+    ys.push_back(maps_y[i]);
+  }
+
+  tk::spline sx, sy;
+  sx.set_points(ss, xs);
+  sy.set_points(ss, ys);
+
+  // one extra sample so the last interval interpolates to s = max_s
+  n_ = (int)ceil(max_s / ds);
+  x_.resize(n_ + 1);
+  y_.resize(n_ + 1);
+  nx_.resize(n_ + 1);
+  ny_.resize(n_ + 1);
+  const double h = 0.01;
+  for(int i = 0; i <= n_; ++i)
+  {
+    double s = std::min(i * ds, max_s);
+    x_[i] = sx(s);
+    y_[i] = sy(s);
+    // heading from the spline slope, the normal is the heading turned right
+    double tx = sx(s + h) - sx(s - h);
+    double ty = sy(s + h) - sy(s - h);
+    double len = sqrt(tx * tx + ty * ty);
+    nx_[i] = ty / len;
+    ny_[i] = -tx / len;
+  }
+}
+
+
+void ReferenceLine::to_xy(const double *s, const double *d, int n, double *x, double *y) const
+{
+  double inv_ds = 1. / ds;
+  for(int i = 0; i < n; ++i)
+  {
+    double si = s[i];
+    if(si < 0. || si >= max_s)
+      si = fmod(fmod(si, max_s) + max_s, max_s);
+    double u = si * inv_ds;
+    int j = std::min((int)u, n_ - 1);
+    double w = u - j;
+
+    double cx = x_[j] + w * (x_[j + 1] - x_[j]);
+    double cy = y_[j] + w * (y_[j + 1] - y_[j]);
+    double nx = nx_[j] + w * (nx_[j + 1] - nx_[j]);
+    double ny = ny_[j] + w * (ny_[j + 1] - ny_[j]);
+    x[i] = cx + d[i] * nx;
+    y[i] = cy + d[i] * ny;
+  }
+}
+
+
+void ReferenceLine::to_xy_spaced(double s0, double d0, const double *step, double *s,
+                                 const double *d, int n, double *x, double *y) const
+{
+  double x0, y0;
+  to_xy(&s0, &d0, 1, &x0, &y0);
+
+  // the stretch of the road changes slowly along s, two passes of scaling
+  // every s step by how far off its (x,y) step is are within a millimeter
+  for(int pass = 0; pass < 2; ++pass)
+  {
+    to_xy(s, d, n, x, y);
+    double px = x0, py = y0;
+    double s_old = s0, s_new = s0;
+    for(int i = 0; i < n; ++i)
+    {
+      double dist = sqrt((x[i] - px) * (x[i] - px) + (y[i] - py) * (y[i] - py));
+      double ds_i = s[i] - s_old;
+      px = x[i];
+      py = y[i];
+      s_old = s[i];
+      s[i] = s_new + (dist > 1e-6 ? ds_i * step[i] / dist : ds_i);
+      s_new = s[i];
+    }
+  }
+  to_xy(s, d, n, x, y);
+}
@@ -0,0 +1,47 @@
+#ifndef REFERENCE_LINE_H
+#define REFERENCE_LINE_H
+#include <vector>
+
+using std::vector;
+
+/*
+ * Smooth center line of the road for converting frenet to world
+ * coordination in bulk.
+ *
+ * Splines through the map waypoints, wrapped around max_s, are sampled
+ * once at startup every `ds` meters into tables of the position and the
+ * unit normal pointing to the right of the road. Converting a point is a
+ * table lookup and two linear interpolations, there is no trigonometry
+ * and no per-frame fit, and the cost doesn't depend on the curvature.
+ */
+class ReferenceLine
+{
+public:
+  double max_s;  // length of the track before s wraps around
+  double ds;     // distance between two samples [m]
+
+  /*
+   * Constructor
+   */
+  ReferenceLine(const vector<double> &maps_s, const vector<double> &maps_x,
+                const vector<double> &maps_y, double max_s, double ds=0.5);
+
+  // convert n points (s[i], d[i]) into (x[i], y[i])
+  void to_xy(const double *s, const double *d, int n, double *x, double *y) const;
+
+  /*
+   * Convert like to_xy, but first move every s[i] so that point i is step[i]
+   * from the point before in (x,y), the first one from (s0, d0). Away from
+   * the center line a curve makes an s step longer or shorter on the road,
+   * this keeps the speed of a path planned along s.
+   */
+  void to_xy_spaced(double s0, double d0, const double *step, double *s, const double *d,
+                    int n, double *x, double *y) const;
+
+private:
+  int n_;
+  vector<double> x_, y_;    // center line
+  vector<double> nx_, ny_;  // unit normal to the right
+};
+
+#endif
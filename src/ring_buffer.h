@@ -0,0 +1,59 @@
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+/*
+ * Fixed-capacity ring buffer which overwrites its oldest element when full.
+ * Storage lives inside the object, so pushing never allocates.
+ */
+template<typename T, int N>
+class RingBuffer
+{
+public:
+  RingBuffer() : head_(0), size_(0) {}
+
+  // append x, dropping the oldest element if the buffer is full
+  void push(const T &x)
+  {
+    data_[head_] = x;
+    head_ = (head_ + 1) % N;
+    if(size_ < N)
+      ++size_;
+  }
+
+  // drop the n oldest elements
+  void pop_front(int n=1)
+  {
+    size_ = n < size_ ? size_ - n : 0;
+  }
+
+  // drop the n newest elements
+  void pop_back(int n=1)
+  {
+    n = n < size_ ? n : size_;
+    head_ = (head_ - n + N) % N;
+    size_ -= n;
+  }
+
+  void clear() { head_ = 0; size_ = 0; }
+
+  int size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  bool full() const { return size_ == N; }
+  static int capacity() { return N; }
+
+  // i = 0 is the oldest element, size() - 1 the newest
+  T &operator[](int i) { return data_[(head_ - size_ + i + N) % N]; }
+  const T &operator[](int i) const { return data_[(head_ - size_ + i + N) % N]; }
+
+  T &back() { return (*this)[size_ - 1]; }
+  const T &back() const { return (*this)[size_ - 1]; }
+  T &front() { return (*this)[0]; }
+  const T &front() const { return (*this)[0]; }
+
+private:
+  T data_[N];
+  int head_;  // where the next element goes
+  int size_;
+};
+
+#endif
@@ -0,0 +1,116 @@
+#include <algorithm>
+#include <math.h>
+#include "s_curve.h"
+
+/*
+ * Initialize SCurveTable
+ */
+
+SCurveTable::SCurveTable(double max_acc, double max_dec, double max_jerk,
+                         double v_max, double v_step, double a_step)
+{
+  this->max_acc = max_acc;
+  this->max_dec = max_dec;
+  this->max_jerk = max_jerk;
+  this->v_step = v_step;
+  this->a_step = a_step;
+  this->n_v = (int)lround(v_max / v_step) + 1;
+  n_a_ = (int)lround((max_acc + max_dec) / a_step) + 1;
+
+  table_.resize(n_v * n_a_ * n_v);
+  for(int i0 = 0; i0 < n_v; ++i0)
+    for(int ia = 0; ia < n_a_; ++ia)
+      for(int i1 = 0; i1 < n_v; ++i1)
+        table_[(i0 * n_a_ + ia) * n_v + i1] = solve(i0 * v_step, -max_dec + ia * a_step, i1 * v_step);
+}
+
+
+double SCurveTable::speed_change(double a0, double peak) const
+{
+  // jerk from a0 to the peak, then from the peak back to 0
+  return fabs(peak - a0) * (a0 + peak) / (2. * max_jerk) + fabs(peak) * peak / (2. * max_jerk);
+}
+
+
+SCurveTable::Phases SCurveTable::solve(double v0, double a0, double v1) const
+{
+  // the speed change grows with the peak, so the peak is found by bisection
+  // and held as long as the limit alone doesn't get to v1
+  double dv = v1 - v0;
+  double lo = -max_dec, hi = max_acc;
+  double hold = 0.;
+  double peak;
+  if(dv >= speed_change(a0, hi))
+  {
+    peak = hi;
+    hold = (dv - speed_change(a0, hi)) / hi;
+  }
+  else if(dv <= speed_change(a0, lo))
+  {
+    peak = lo;
+    hold = (dv - speed_change(a0, lo)) / lo;
+  }
+  else
+  {
+    for(int i = 0; i < 40; ++i)
+    {
+      double mid = 0.5 * (lo + hi);
+      if(speed_change(a0, mid) < dv)
+        lo = mid;
+      else
+        hi = mid;
+    }
+    peak = 0.5 * (lo + hi);
+  }
+
+  Phases p;
+  p.peak = peak;
+  p.t1 = fabs(peak - a0) / max_jerk;
+  p.t2 = hold;
+  p.t3 = fabs(peak) / max_jerk;
+  return p;
+}
+
+
+void SCurveTable::profile(double v0, double a0, double v1, int n, double dt,
+                          double *speed, double *acc) const
+{
+  auto index = [](double x, double lo, double step, int size)
+  {
+    return std::min(std::max((int)lround((x - lo) / step), 0), size - 1);
+  };
+  const Phases &p = table_[(index(v0, 0., v_step, n_v) * n_a_ +
+                            index(a0, -max_dec, a_step, n_a_)) * n_v +
+                           index(v1, 0., v_step, n_v)];
+
+  double j1 = (p.peak >= a0) ? max_jerk : -max_jerk;
+  double j3 = (p.peak >= 0.) ? -max_jerk : max_jerk;
+  double end1 = p.t1, end2 = p.t1 + p.t2, end3 = p.t1 + p.t2 + p.t3;
+  double v = v0, a = a0;
+  for(int k = 0; k < n; ++k)
+  {
+    double t = (k + 0.5) * dt;
+    double jerk;
+    if(t < end1)
+      jerk = j1;
+    else if(t < end2)
+      jerk = 0.;
+    else if(t < end3)
+      jerk = j3;
+    else
+      // the grid leaves a small acceleration, take it away within the jerk limit
+      jerk = -std::min(std::max(a / dt, -max_jerk), max_jerk);
+
+    double a_next = std::min(std::max(a + jerk * dt, -max_dec), max_acc);
+    v += 0.5 * (a + a_next) * dt;
+    a = a_next;
+    if(v < 0.)
+    {
+      v = 0.;
+      a = 0.;
+    }
+    speed[k] = v;
+    if(acc)
+      acc[k] = a;
+  }
+}
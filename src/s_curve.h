@@ -0,0 +1,57 @@
+#ifndef S_CURVE_H
+#define S_CURVE_H
+#include <vector>
+
+using std::vector;
+
+/*
+ * Jerk-limited (S-curve) speed changes from tables.
+ *
+ * Going from speed v0 and acceleration a0 to speed v1 takes three phases:
+ * jerk towards a peak acceleration, hold it, jerk back to zero. The peak
+ * and the phase durations are computed once at startup for a grid of
+ * (v0, a0, v1), and a frame only looks them up. Emitting the points walks
+ * the phases from the actual v0 and a0; the acceleration is kept inside
+ * [-max_dec, max_acc] and changes by at most max_jerk, so every point is
+ * within the limits even when the grid is a bit off.
+ */
+class SCurveTable
+{
+public:
+  double max_acc;   // [m/s^2]
+  double max_dec;   // hardest braking, positive [m/s^2]
+  double max_jerk;  // [m/s^3]
+  double v_step;    // grid of the speeds [m/s]
+  double a_step;    // grid of the start acceleration [m/s^2]
+  int n_v;          // speeds 0, v_step, ... on the grid
+
+  /*
+   * Constructor, computes the tables
+   */
+  SCurveTable(double max_acc=5., double max_dec=7., double max_jerk=8.,
+              double v_max=24., double v_step=0.5, double a_step=0.5);
+
+  /*
+   * Speed and acceleration of n points every dt seconds from (v0, a0)
+   * towards v1, point k being at time (k + 1) * dt. acc may be nullptr.
+   */
+  void profile(double v0, double a0, double v1, int n, double dt,
+               double *speed, double *acc=nullptr) const;
+
+private:
+  struct Phases
+  {
+    float peak;  // acceleration held in the middle phase
+    float t1;    // jerk from a0 to the peak [s]
+    float t2;    // hold the peak [s]
+    float t3;    // jerk from the peak to 0 [s]
+  };
+
+  int n_a_;
+  vector<Phases> table_;  // (v0, a0, v1), v1 the fastest changing index
+
+  Phases solve(double v0, double a0, double v1) const;
+  double speed_change(double a0, double peak) const;
+};
+
+#endif
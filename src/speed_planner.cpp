@@ -0,0 +1,231 @@
+#include <algorithm>
+#include <math.h>
+#include "speed_planner.h"
+
+static const float unreachable = 1e30f;
+
+/*
+ * Initialize SpeedPlanner
+ */
+
+SpeedPlanner::SpeedPlanner(double max_s, double v_max, int num_steps, double dt,
+                           double acc_res, double min_acc, double max_acc, int max_jerk_levels,
+                           double cell_len, int num_cells)
+{
+  this->max_s = max_s;
+  this->v_max = v_max;
+  this->num_steps = num_steps;
+  this->dt = dt;
+  this->acc_res = acc_res;
+  this->min_acc = min_acc;
+  this->max_acc = max_acc;
+  this->max_jerk_levels = max_jerk_levels;
+  this->cell_len = cell_len;
+  this->num_cells = num_cells;
+  this->headway = 1.0;
+  this->min_gap = 8.;
+  this->half_len = 2.5;
+  this->w_speed = 1.;
+  this->w_acc = 0.5;
+  this->w_jerk = 0.05;
+  this->w_gap = 5.;
+
+  num_acc_ = (int)lround((max_acc - min_acc) / acc_res) + 1;
+  v_res_ = acc_res * dt;
+  // room above the speed limit for the levels of the start speed
+  num_v_ = (int)ceil(v_max / v_res_) + 2;
+  num_states_ = num_v_ * num_acc_;
+  v_base_ = 0.;
+
+  // step 0 is the start, so there are num_steps + 1 rows
+  taken_.assign((num_steps + 1) * num_cells, 0);
+  free_.assign((num_steps + 1) * num_cells, 0.f);
+  cost_.assign((num_steps + 1) * num_states_, unreachable);
+  s_.assign((num_steps + 1) * num_states_, 0.f);
+  parent_.assign((num_steps + 1) * num_states_, -1);
+  v_plan_.assign(num_steps + 1, 0.);
+  a_plan_.assign(num_steps + 1, 0.);
+  s_plan_.assign(num_steps + 1, 0.);
+}
+
+
+void SpeedPlanner::set_obstacles(const Prediction &pred, double s0, double t0,
+                                 double d_lo, double d_hi)
+{
+  std::fill(taken_.begin(), taken_.end(), 0);
+  int last = pred.num_steps - 1;
+  for(int k = 0; k <= num_steps; ++k)
+  {
+    double time = t0 + k * dt;
+    int t = std::min(std::max((int)lround(time / pred.dt), 0), last);
+    int t_prev = std::max(t - 1, 0);
+    double extra = std::max(time - t * pred.dt, 0.);
+    unsigned char *row = &taken_[k * num_cells];
+    for(int i = 0; i < pred.size; ++i)
+    {
+      double d = pred.d(t, i);
+      if(d < d_lo || d > d_hi)
+        continue;
+
+      double v = (t > t_prev) ? (pred.s(t, i) - pred.s(t_prev, i)) / ((t - t_prev) * pred.dt) : 0.;
+      // the short way around the track to the path start
+      double ds = fmod(pred.s(t, i) + v * extra - s0, max_s);
+      if(ds >= 0.5 * max_s)
+        ds -= max_s;
+      else if(ds < -0.5 * max_s)
+        ds += max_s;
+
+      // cars behind the start don't hold us back
+      if(ds + half_len < 0.)
+        continue;
+      int lo = std::max((int)floor((ds - half_len) / cell_len), 0);
+      int hi = std::min((int)floor((ds + half_len) / cell_len), num_cells - 1);
+      for(int c = lo; c <= hi; ++c)
+        row[c] = 1;
+    }
+
+    // distance to the next taken cell ahead, from the far end back
+    float *fr = &free_[k * num_cells];
+    float next = 1e4f;
+    for(int c = num_cells - 1; c >= 0; --c)
+    {
+      next = row[c] ? 0.f : next + cell_len;
+      fr[c] = next;
+    }
+  }
+}
+
+
+double SpeedPlanner::gap(int k, double s) const
+{
+  int c = (int)floor(s / cell_len);
+  if(c < 0)
+    return free_[k * num_cells];
+  if(c >= num_cells)
+    return 1e4;
+  return free_[k * num_cells + c];
+}
+
+
+void SpeedPlanner::plan(double v0, double a0)
+{
+  // put the start speed on the grid, level 0 is just above standing still
+  int v_start = std::min((int)floor(v0 / v_res_), num_v_ - 1);
+  v_base_ = v0 - v_start * v_res_;
+  int a_start = std::min(std::max((int)lround((a0 - min_acc) / acc_res), 0), num_acc_ - 1);
+
+  std::fill(cost_.begin(), cost_.end(), unreachable);
+  // parents of an earlier plan must not lead the walk back
+  std::fill(parent_.begin(), parent_.end(), -1);
+  int start = v_start * num_acc_ + a_start;
+  int a_zero = (int)lround(-min_acc / acc_res);
+  cost_[start] = 0.f;
+  s_[start] = 0.f;
+  parent_[start] = -1;
+
+  for(int k = 1; k <= num_steps; ++k)
+  {
+    const float *prev_cost = &cost_[(k - 1) * num_states_];
+    const float *prev_s = &s_[(k - 1) * num_states_];
+    float *cost = &cost_[k * num_states_];
+    float *s = &s_[k * num_states_];
+    int *parent = &parent_[k * num_states_];
+    for(int p = 0; p < num_states_; ++p)
+    {
+      if(prev_cost[p] >= unreachable)
+        continue;
+
+      int pv = p / num_acc_;
+      int pa = p % num_acc_;
+      double v_from = v_base_ + pv * v_res_;
+      int a_lo = std::max(pa - max_jerk_levels, 0);
+      int a_hi = std::min(pa + max_jerk_levels, num_acc_ - 1);
+      for(int na = a_lo; na <= a_hi; ++na)
+      {
+        // the speed moves by the new acceleration, one speed level per acceleration level
+        int nv = pv + (int)lround((min_acc + na * acc_res) / acc_res);
+        if(nv >= num_v_)
+          continue;
+        int a_to = na;
+        // braking below the lowest level stops the car, and it stays stopped
+        if(nv < 0)
+        {
+          nv = 0;
+          a_to = a_zero;
+        }
+
+        double v_to = v_base_ + nv * v_res_;
+        double acc = min_acc + a_to * acc_res;
+        double jerk = (a_to - pa) * acc_res / dt;
+        double s_to = prev_s[p] + 0.5 * (v_from + v_to) * dt;
+
+        double dv = v_max - v_to;
+        double c = w_speed * dv * dv + w_acc * acc * acc + w_jerk * jerk * jerk;
+        if(v_to > v_max)
+          c += 100. * dv * dv;
+        double g = gap(k, s_to);
+        if(g <= 0.)
+          c += 1e6;
+        double safe = min_gap + headway * v_to;
+        if(g < safe)
+          c += w_gap * (safe - g) * (safe - g);
+        c = prev_cost[p] + c * dt;
+
+        int n = nv * num_acc_ + a_to;
+        if(c < cost[n])
+        {
+          cost[n] = c;
+          s[n] = s_to;
+          parent[n] = p;
+        }
+      }
+    }
+  }
+
+  // walk back from the cheapest final state
+  const float *last = &cost_[num_steps * num_states_];
+  int best = std::min_element(last, last + num_states_) - last;
+  if(last[best] >= unreachable)
+  {
+    // no profile reaches the horizon, hold the current speed
+    for(int k = 0; k <= num_steps; ++k)
+    {
+      v_plan_[k] = v0;
+      a_plan_[k] = 0.;
+      s_plan_[k] = v0 * k * dt;
+    }
+    return;
+  }
+  for(int k = num_steps; k >= 0 && best >= 0; --k)
+  {
+    v_plan_[k] = v_base_ + (best / num_acc_) * v_res_;
+    a_plan_[k] = min_acc + (best % num_acc_) * acc_res;
+    s_plan_[k] = s_[k * num_states_ + best];
+    if(k > 0)
+      best = parent_[k * num_states_ + best];
+  }
+}
+
+
+double SpeedPlanner::speed_at(double t) const
+{
+  double x = std::min(std::max(t / dt, 0.), (double)num_steps);
+  int k = std::min((int)x, num_steps - 1);
+  return v_plan_[k] + (x - k) * (v_plan_[k + 1] - v_plan_[k]);
+}
+
+
+double SpeedPlanner::accel_at(double t) const
+{
+  // the acceleration of a state is the one which led to it
+  int k = std::min(std::max((int)ceil(t / dt), 1), num_steps);
+  return a_plan_[k];
+}
+
+
+double SpeedPlanner::s_at(double t) const
+{
+  double x = std::min(std::max(t / dt, 0.), (double)num_steps);
+  int k = std::min((int)x, num_steps - 1);
+  return s_plan_[k] + (x - k) * (s_plan_[k + 1] - s_plan_[k]);
+}
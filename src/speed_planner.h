@@ -0,0 +1,92 @@
+#ifndef SPEED_PLANNER_H
+#define SPEED_PLANNER_H
+#include <vector>
+#include "prediction.h"
+
+using std::vector;
+
+/*
+ * Speed profile along the chosen path from dynamic programming in the
+ * s-t plane.
+ *
+ * The s-t plane ahead of the path start is cut into 1 m cells for every
+ * step of `dt` seconds, and the predicted cars of the lanes we drive in
+ * mark the cells they cover. For each row the distance to the next taken
+ * cell ahead is kept, so the DP reads the gap to the car ahead with one
+ * lookup.
+ *
+ * A DP state is (speed, acceleration) at a step; the acceleration moves
+ * by at most `max_jerk_levels` levels per step, which bounds the jerk,
+ * and the speed moves by the acceleration, so all speeds lie on one grid.
+ * Every state keeps the s of its best way there. The cost is the squared
+ * distance to the speed limit, acceleration and jerk, plus a penalty when
+ * the gap to the car ahead gets below the time gap and a huge one for
+ * driving into a taken cell, so there is always a profile, braking as
+ * hard as allowed if need be.
+ *
+ * The s-t rows and the cost layers are row-major (step by step) and are
+ * allocated once. The profile depends on time only, not on how often the
+ * simulator sends telemetry.
+ */
+class SpeedPlanner
+{
+public:
+  double dt;          // time between two steps [s]
+  int num_steps;      // steps of the horizon
+  double v_max;       // speed limit to go for [m/s]
+  double acc_res;     // difference between two acceleration levels [m/s^2]
+  double min_acc;     // hardest braking [m/s^2]
+  double max_acc;     // strongest speed up [m/s^2]
+  int max_jerk_levels;  // acceleration levels the acceleration may move per step
+  double cell_len;    // length of one s-cell [m]
+  int num_cells;      // s-cells ahead of the path start
+  double headway;     // time gap kept to a car ahead [s]
+  double min_gap;     // distance kept to a car ahead [m]
+  double half_len;    // half length of a car [m]
+  double max_s;       // length of the track before s wraps around
+  double w_speed, w_acc, w_jerk, w_gap;
+
+  /*
+   * Constructor
+   */
+  SpeedPlanner(double max_s, double v_max=49.5 / 2.24, int num_steps=12, double dt=0.25,
+               double acc_res=1., double min_acc=-7., double max_acc=5., int max_jerk_levels=2,
+               double cell_len=1., int num_cells=200);
+
+  /*
+   * Mark the cars of the prediction with d in [d_lo, d_hi] in the s-t plane.
+   * The plan starts at s0 along the path, t0 seconds after prediction step 0.
+   * Cars are extended at constant speed beyond the prediction horizon.
+   */
+  void set_obstacles(const Prediction &pred, double s0, double t0, double d_lo, double d_hi);
+
+  // best profile from speed v0 [m/s] and acceleration a0 [m/s^2]
+  void plan(double v0, double a0);
+
+  // planned speed, acceleration and distance from the start at time t
+  double speed_at(double t) const;
+  double accel_at(double t) const;
+  double s_at(double t) const;
+
+  // gap to the car ahead at the start, a large value if there is none
+  double gap_ahead() const { return free_[0]; }
+
+private:
+  int num_acc_;
+  int num_v_;
+  int num_states_;   // num_v_ * num_acc_, state = v * num_acc_ + a
+  double v_res_;     // acc_res * dt
+  double v_base_;    // speed of level 0
+
+  vector<unsigned char> taken_;  // (step, cell) covered by a car
+  vector<float> free_;           // (step, cell) distance to the next taken cell ahead
+  vector<float> cost_;           // (step, state)
+  vector<float> s_;              // (step, state) distance of the best way there
+  vector<int> parent_;           // (step, state)
+
+  vector<double> v_plan_, a_plan_, s_plan_;  // profile at every step
+
+  double gap(int k, double s) const;
+};
+
+#endif
@@ -0,0 +1,86 @@
+#include <algorithm>
+#include <math.h>
+#include "steady_cruise.h"
+
+/*
+ * Initialize SteadyCruise
+ */
+
+SteadyCruise::SteadyCruise(double v_cap, double v_tol, double min_gap, double d_tol, int max_frames,
+                           double max_jerk)
+{
+  this->v_cap = v_cap;
+  this->v_tol = v_tol;
+  this->min_gap = min_gap;
+  this->d_tol = d_tol;
+  this->max_frames = max_frames;
+  this->max_jerk = max_jerk;
+
+  this->fast_count = 0;
+  this->full_count = 0;
+  this->held_count = 0;
+  this->streak_ = 0;
+}
+
+
+bool SteadyCruise::check(const EmittedPath &emitted, double center_d, double front_dist, bool cut_in,
+                         bool lane_change)
+{
+  bool steady = false;
+  if(emitted.size() >= 2 && streak_ < max_frames && !cut_in && !lane_change && front_dist > min_gap)
+  {
+    const PathPoint &end = emitted.back();
+    steady = end.v > v_cap - v_tol && fabs(end.a) <= max_jerk * .02 &&
+             fabs(end.d - center_d) < d_tol && fabs(end.vd) < 0.5;
+  }
+
+  if(steady)
+  {
+    ++streak_;
+    ++fast_count;
+  }
+  else
+  {
+    streak_ = 0;
+    ++full_count;
+  }
+  return steady;
+}
+
+
+void SteadyCruise::extend(const ReferenceLine &ref_line, EmittedPath &emitted, double center_d,
+                          int n_points) const
+{
+  PathPoint p = emitted.back();
+
+  // where the reference line puts the path end, the rest is the offset to keep
+  double x0, y0;
+  ref_line.to_xy(&p.s, &center_d, 1, &x0, &y0);
+  double off_x = p.x - x0;
+  double off_y = p.y - y0;
+
+  p.a = 0.;
+  p.vd = 0.;
+  p.ad = 0.;
+  p.d = center_d;
+  double step = std::min(p.v, v_cap) * .02;
+  for(int i = emitted.size(); i < n_points; ++i)
+  {
+    // an s step of the speed first, then scaled to drive that far in x and y
+    double x_prev = p.x, y_prev = p.y;
+    double ds = step;
+    for(int pass = 0; pass < 2; ++pass)
+    {
+      double s = fmod(p.s + ds, ref_line.max_s);
+      ref_line.to_xy(&s, &center_d, 1, &p.x, &p.y);
+      p.x += off_x;
+      p.y += off_y;
+      double dist = sqrt((p.x - x_prev) * (p.x - x_prev) + (p.y - y_prev) * (p.y - y_prev));
+      if(pass == 0 && dist > 1e-6)
+        ds *= step / dist;
+    }
+    p.s = fmod(p.s + ds, ref_line.max_s);
+    p.v = step / .02;
+    emitted.push(p);
+  }
+}
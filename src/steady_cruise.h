@@ -0,0 +1,74 @@
+#ifndef STEADY_CRUISE_H
+#define STEADY_CRUISE_H
+#include "emitted_path.h"
+#include "reference_line.h"
+
+/*
+ * Fast path for cruising alone in a lane at the speed limit.
+ *
+ * With nothing ahead, no lane change going on and the speed at its cap,
+ * a full replan comes up with the same path every frame. In that steady
+ * state the path is only extended by the points the simulator drove,
+ * along the lane center of the reference line at constant speed, and
+ * prediction, search, speed planning and the candidate checks are all
+ * skipped. A full replan still runs every `max_frames` frames.
+ *
+ * The speed is kept on the (x,y) points: away from the reference line a
+ * step in s is longer or shorter on the road depending on the curve, so
+ * every s step is scaled to the distance the car drives in one point.
+ */
+class SteadyCruise
+{
+public:
+  double v_cap;     // speed limit the car has to be at [m/s]
+  double v_tol;     // how far below the limit still counts as cruising [m/s]
+  double min_gap;   // free road needed ahead in our lane [m]
+  double d_tol;     // how far from the lane center the path may end [m]
+  int max_frames;   // fast frames in a row before a full replan
+  double max_jerk;  // jerk limit of the speed profile [m/s^3]
+
+  // frames since the start which extended the path, replanned it or held it
+  long fast_count;
+  long full_count;
+  long held_count;
+
+  /*
+   * Constructor
+   */
+  SteadyCruise(double v_cap=49.5 / 2.24, double v_tol=0.25, double min_gap=90.,
+               double d_tol=0.25, int max_frames=25, double max_jerk=8.);
+
+  /*
+   * Check whether the path, which ends in state end with n_kept points left,
+   * can be extended along the lane at center_d. front_dist is the gap to the
+   * car ahead in that lane, cut_in tells if any car is about to enter it and
+   * lane_change if we change lane or are about to. The acceleration at the
+   * path end has to be small enough to drop to 0 within one point at
+   * max_jerk. Counts the frame as fast or full.
+   */
+  bool check(const EmittedPath &emitted, double center_d, double front_dist, bool cut_in,
+             bool lane_change);
+
+  // count a frame which sent the points left without looking at the path
+  void hold() { ++held_count; }
+
+  /*
+   * Append points at the speed of the path end along the lane at center_d
+   * until the path has n_points points. The offset between the path end and
+   * the reference line is carried along, so there is no step in the path.
+   */
+  void extend(const ReferenceLine &ref_line, EmittedPath &emitted, double center_d,
+              int n_points) const;
+
+  // share of all frames which took the fast path
+  double fast_rate() const
+  {
+    long total = fast_count + full_count + held_count;
+    return total > 0 ? (double)fast_count / total : 0.;
+  }
+
+private:
+  int streak_;  // fast frames since the last full replan
+};
+
+#endif
@@ -0,0 +1,213 @@
+#include <math.h>
+#include "Eigen-3.3/Eigen/LU"
+#include "tracker.h"
+
+// shortest signed difference between two positions on a loop of length wrap
+static double wrap_diff(double a, double b, double wrap)
+{
+  double diff = a - b;
+  if(wrap > 0)
+  {
+    diff = fmod(diff, wrap);
+    if(diff >= 0.5 * wrap)
+      diff -= wrap;
+    else if(diff < -0.5 * wrap)
+      diff += wrap;
+  }
+  return diff;
+}
+
+
+void AxisFilter::init(double p, double v)
+{
+  x << p, v, 0.;
+  P = Eigen::Matrix3d::Zero();
+  P(0, 0) = 1.;
+  P(1, 1) = 1.;
+  P(2, 2) = 4.;
+}
+
+
+void AxisFilter::predict(double dt, double q)
+{
+  Eigen::Matrix3d F;
+  F << 1., dt, 0.5 * dt * dt,
+       0., 1., dt,
+       0., 0., 1.;
+
+  // white jerk noise integrated over dt
+  double dt2 = dt * dt;
+  double dt3 = dt2 * dt;
+  Eigen::Matrix3d Q;
+  Q << dt3 * dt2 / 20., dt2 * dt2 / 8., dt3 / 6.,
+       dt2 * dt2 / 8.,  dt3 / 3.,       dt2 / 2.,
+       dt3 / 6.,        dt2 / 2.,       dt;
+
+  x = F * x;
+  P = F * P * F.transpose() + q * Q;
+}
+
+
+void AxisFilter::update(double p, double v, double r_p, double r_v, double wrap)
+{
+  // H picks position and velocity out of the state
+  Eigen::Vector2d y(wrap_diff(p, x(0), wrap), v - x(1));
+  Eigen::Matrix2d S = P.topLeftCorner<2, 2>();
+  S(0, 0) += r_p;
+  S(1, 1) += r_v;
+  Eigen::Matrix<double, 3, 2> K = P.leftCols<2>() * S.inverse();
+
+  x += K * y;
+  P -= K * P.topRows<2>();
+  if(wrap > 0)
+  {
+    x(0) = fmod(x(0), wrap);
+    if(x(0) < 0)
+      x(0) += wrap;
+  }
+}
+
+/*
+ * Initialize Tracker
+ */
+
+Tracker::Tracker(double max_s, int capacity, double range, int max_missed)
+{
+  this->max_s = max_s;
+  this->range = range;
+  this->max_missed = max_missed;
+  this->q_s = 2.;
+  this->q_d = 0.5;
+  this->r_pos = 0.05;
+  this->r_vel = 0.25;
+
+  // keep the table at most half full so probe chains stay short
+  int n = 1;
+  while(n < 2 * capacity)
+    n <<= 1;
+  slots_.resize(n);
+  for(auto &tr : slots_)
+    tr.id = -1;
+  mask_ = n - 1;
+  size_ = 0;
+  t_ = 0.;
+  ego_s_ = 0.;
+}
+
+
+void Tracker::begin_frame(double t, double ego_s)
+{
+  t_ = t;
+  ego_s_ = ego_s;
+  for(auto &tr : slots_)
+  {
+    if(tr.id >= 0)
+      tr.missed++;
+  }
+}
+
+
+int Tracker::probe(int id) const
+{
+  int i = home(id);
+  while(slots_[i].id >= 0 && slots_[i].id != id)
+    i = (i + 1) & mask_;
+  return i;
+}
+
+
+const Track *Tracker::update(int id, double s, double d, double vs, double vd)
+{
+  int i = probe(id);
+  Track &tr = slots_[i];
+
+  if(tr.id < 0)
+  {
+    // a new car, refuse it rather than let the table get crowded
+    if(2 * (size_ + 1) > (int)slots_.size())
+      return nullptr;
+    tr.id = id;
+    tr.age = 0;
+    tr.t0 = t_;
+    tr.history.clear();
+    tr.d_fit.clear();
+    tr.vd_fit.clear();
+    tr.fs.init(s, vs);
+    tr.fd.init(d, vd);
+    size_++;
+  }
+  else
+  {
+    double dt = t_ - tr.last_t;
+    if(dt > 0)
+    {
+      tr.fs.predict(dt, q_s);
+      tr.fd.predict(dt, q_d);
+    }
+    tr.fs.update(s, vs, r_pos, r_vel, max_s);
+    tr.fd.update(d, vd, r_pos, r_vel, 0.);
+    tr.age++;
+  }
+
+  tr.missed = 0;
+  tr.last_t = t_;
+  // slide the lateral fits along with the history
+  if(tr.history.full())
+  {
+    const TrackSample &oldest = tr.history.front();
+    tr.d_fit.remove(oldest.t - tr.t0, oldest.d);
+    tr.vd_fit.remove(oldest.t - tr.t0, oldest.vd);
+  }
+  TrackSample sample = {t_, s, d, vs, vd};
+  tr.history.push(sample);
+  tr.d_fit.add(t_ - tr.t0, d);
+  tr.vd_fit.add(t_ - tr.t0, vd);
+
+  return &tr;
+}
+
+
+const Track *Tracker::find(int id) const
+{
+  int i = probe(id);
+  return slots_[i].id == id ? &slots_[i] : nullptr;
+}
+
+
+void Tracker::erase(int slot)
+{
+  // shift the following entries of the probe chain back into the hole
+  int hole = slot;
+  int j = slot;
+  while(true)
+  {
+    j = (j + 1) & mask_;
+    if(slots_[j].id < 0)
+      break;
+    int k = home(slots_[j].id);
+    bool stays = (hole <= j) ? (hole < k && k <= j) : (hole < k || k <= j);
+    if(stays)
+      continue;
+    slots_[hole] = slots_[j];
+    hole = j;
+  }
+  slots_[hole].id = -1;
+  size_--;
+}
+
+
+void Tracker::end_frame()
+{
+  for(int i = 0; i <= mask_; )
+  {
+    Track &tr = slots_[i];
+    if(tr.id >= 0 &&
+       (tr.missed > max_missed || fabs(wrap_diff(tr.s(), ego_s_, max_s)) > range))
+    {
+      // the backward shift may move another track into slot i, look at it again
+      erase(i);
+      continue;
+    }
+    ++i;
+  }
+}
@@ -0,0 +1,111 @@
+#ifndef TRACKER_H
+#define TRACKER_H
+#include <vector>
+#include "Eigen-3.3/Eigen/Core"
+#include "ring_buffer.h"
+#include "line_fit.h"
+
+using std::vector;
+
+/*
+ * One raw measurement of a tracked car in frenet coordination.
+ */
+struct TrackSample
+{
+  double t;       // time of the measurement [s]
+  double s, d;
+  double vs, vd;  // velocity along and across the road [m/s]
+};
+
+/*
+ * Constant-acceleration Kalman filter of one axis, state (p, v, a).
+ * Position and velocity are measured.
+ */
+struct AxisFilter
+{
+  Eigen::Vector3d x;
+  Eigen::Matrix3d P;
+
+  void init(double p, double v);
+  void predict(double dt, double q);
+  // wrap is the period of the position (max_s along the road), 0 if none
+  void update(double p, double v, double r_p, double r_v, double wrap);
+};
+
+/*
+ * A car followed across frames by its sensor fusion ID.
+ */
+struct Track
+{
+  static const int history_len = 32;
+
+  int id;           // sensor fusion ID, -1 for an empty slot
+  int missed;       // frames since the car was last seen
+  int age;          // frames since the track started
+  double t0;        // time the track started [s]
+  double last_t;    // time of the last update [s]
+  AxisFilter fs;    // along the road
+  AxisFilter fd;    // across the road
+  RingBuffer<TrackSample, history_len> history;
+  // lines through d and the measured vd of the history, times relative to t0
+  LineFit d_fit;
+  LineFit vd_fit;
+
+  double s() const { return fs.x(0); }
+  double vs() const { return fs.x(1); }
+  double as() const { return fs.x(2); }
+  double d() const { return fd.x(0); }
+  double vd() const { return fd.x(1); }
+  double ad() const { return fd.x(2); }
+};
+
+/*
+ * Track table keyed by sensor fusion ID.
+ *
+ * Tracks live in a flat open-addressing table (linear probing, deletion
+ * by backward shift), so a lookup is a couple of probes and the table is
+ * allocated once. Every frame updates the tracks in place, tracks which
+ * leave the range around the ego car or are not seen for a while are
+ * evicted in end_frame().
+ */
+class Tracker
+{
+public:
+  double max_s;       // length of the track before s wraps around
+  double range;       // evict tracks farther than this from the ego car [m]
+  int max_missed;     // evict tracks not seen for this many frames
+  double q_s, q_d;    // process noise (jerk spectral density) along and across the road
+  double r_pos, r_vel;  // measurement noise variance of position and velocity
+
+  /*
+   * Constructor
+   */
+  Tracker(double max_s, int capacity=256, double range=300., int max_missed=25);
+
+  // start a frame measured at time t [s] with the ego car at ego_s
+  void begin_frame(double t, double ego_s);
+
+  // update (or start) the track of a car and return it, nullptr if the table is full
+  const Track *update(int id, double s, double d, double vs, double vd);
+
+  // evict lost tracks
+  void end_frame();
+
+  // get the track of id, nullptr if there is none
+  const Track *find(int id) const;
+
+  int size() const { return size_; }
+
+private:
+  vector<Track> slots_;
+  int mask_;
+  int size_;
+  double t_;
+  double ego_s_;
+
+  int home(int id) const { return (int)(((unsigned)id * 2654435761u) & (unsigned)mask_); }
+  int probe(int id) const;
+  void erase(int slot);
+};
+
+#endif
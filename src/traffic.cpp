@@ -0,0 +1,112 @@
+#include <algorithm>
+#include <math.h>
+#include "traffic.h"
+
+/*
+ * Initialize TrafficSnapshot
+ */
+
+TrafficSnapshot::TrafficSnapshot(const LaneTopology &lanes, int capacity,
+                                 double s_behind, double s_ahead)
+  : lanes_(&lanes)
+{
+  this->max_s = lanes.max_s;
+  this->num_lanes = std::min(lanes.max_lanes(), (int)max_lanes);
+  this->s_behind = s_behind;
+  this->s_ahead = s_ahead;
+  this->size = 0;
+  this->ego_s_ = 0.;
+  this->capacity_ = std::min(capacity, (int)max_cars);
+  this->n_raw_ = 0;
+
+  // nothing to allocate, the arrays are part of the snapshot
+  std::fill(lane_start_, lane_start_ + max_lanes + 1, 0);
+}
+
+
+void TrafficSnapshot::reset(double ego_s)
+{
+  ego_s_ = ego_s;
+  n_raw_ = 0;
+  size = 0;
+  std::fill(lane_start_, lane_start_ + num_lanes + 1, 0);
+}
+
+
+bool TrafficSnapshot::add(int id, double x, double y, double vx, double vy, double s, double d,
+                          double vs, double vd, double as, double ad)
+{
+  // take the short way around the track and cull cars outside the window
+  double ds = fmod(s - ego_s_, max_s);
+  if(ds >= 0.5 * max_s)
+    ds -= max_s;
+  else if(ds < -0.5 * max_s)
+    ds += max_s;
+  if(ds < -s_behind || ds > s_ahead || n_raw_ >= capacity_)
+    return false;
+
+  int i = n_raw_++;
+  raw_id_[i] = id;
+  raw_x_[i] = x;
+  raw_y_[i] = y;
+  raw_vx_[i] = vx;
+  raw_vy_[i] = vy;
+  raw_s_[i] = s;
+  raw_d_[i] = d;
+  raw_rel_s_[i] = ds;
+  raw_vs_[i] = vs;
+  raw_vd_[i] = vd;
+  raw_as_[i] = as;
+  raw_ad_[i] = ad;
+
+  return true;
+}
+
+
+void TrafficSnapshot::finish()
+{
+  int n = n_raw_;
+
+  // lane assignment is one floor-divide per car, cars off the road go to the nearest lane
+  lanes_->assign(raw_d_, raw_lane_, n);
+  // a road with more lanes than a snapshot holds puts the rest into the last one
+  for(int i = 0; i < n; ++i)
+    raw_lane_[i] = std::min(raw_lane_[i], num_lanes - 1);
+
+  // counting sort by lane, then sort every lane by s
+  std::fill(lane_start_, lane_start_ + num_lanes + 1, 0);
+  for(int i = 0; i < n; ++i)
+    lane_start_[raw_lane_[i] + 1]++;
+  for(int ln = 0; ln < num_lanes; ++ln)
+    lane_start_[ln + 1] += lane_start_[ln];
+  // fill every lane backwards from its end, then move the cursors back to the ends
+  for(int i = 0; i < n; ++i)
+    order_[--lane_start_[raw_lane_[i] + 1]] = i;
+  for(int i = 0; i < n; ++i)
+    lane_start_[raw_lane_[i] + 1]++;
+
+  for(int ln = 0; ln < num_lanes; ++ln)
+  {
+    std::sort(order_ + lane_start_[ln], order_ + lane_start_[ln + 1],
+              [this](int a, int b) { return raw_rel_s_[a] < raw_rel_s_[b]; });
+  }
+
+  for(int j = 0; j < n; ++j)
+  {
+    int i = order_[j];
+    id[j] = raw_id_[i];
+    x[j] = raw_x_[i];
+    y[j] = raw_y_[i];
+    vx[j] = raw_vx_[i];
+    vy[j] = raw_vy_[i];
+    s[j] = raw_s_[i];
+    d[j] = raw_d_[i];
+    rel_s[j] = raw_rel_s_[i];
+    vs[j] = raw_vs_[i];
+    vd[j] = raw_vd_[i];
+    as[j] = raw_as_[i];
+    ad[j] = raw_ad_[i];
+    lane[j] = raw_lane_[i];
+  }
+  size = n;
+}
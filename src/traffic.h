@@ -0,0 +1,75 @@
+#ifndef TRAFFIC_H
+#define TRAFFIC_H
+#include <type_traits>
+#include "lane_topology.h"
+
+/*
+ * Snapshot of the traffic around the ego car in SoA form.
+ *
+ * All arrays live inside the object and are rebuilt in place every frame,
+ * so a frame never allocates and a snapshot is copied like plain data. Cars
+ * outside the s-window around the ego car are culled while they are
+ * added, so no later stage ever sees them. After finish() the cars are
+ * grouped by lane and sorted by s inside every lane, lane ln occupying
+ * the range [lane_begin(ln), lane_end(ln)).
+ */
+class TrafficSnapshot
+{
+public:
+  double max_s;     // length of the track before s wraps around
+  double s_behind;  // keep cars up to this far behind the ego car [m]
+  double s_ahead;   // keep cars up to this far ahead of the ego car [m]
+  static const int max_cars = 256;  // more cars than this are dropped
+  static const int max_lanes = 8;
+
+  int num_lanes;
+  int size;         // number of cars kept in this frame
+
+  int id[max_cars];
+  double x[max_cars], y[max_cars];    // position in the world coordination
+  double vx[max_cars], vy[max_cars];  // velocity in the world coordination
+  double s[max_cars], d[max_cars];    // position in the frenet coordination
+  double rel_s[max_cars];             // s relative to the ego car, the short way around the track
+  double vs[max_cars], vd[max_cars];  // velocity along and across the road
+  double as[max_cars], ad[max_cars];  // acceleration along and across the road, 0 if unknown
+  int lane[max_cars];
+
+  /*
+   * Constructor, capacity is at most max_cars
+   */
+  TrafficSnapshot(const LaneTopology &lanes, int capacity=max_cars,
+                  double s_behind=100., double s_ahead=250.);
+
+  // start a new frame around the ego car at ego_s
+  void reset(double ego_s);
+
+  // add a car, returns false if it is culled or the snapshot is full
+  bool add(int id, double x, double y, double vx, double vy, double s, double d,
+           double vs, double vd, double as=0., double ad=0.);
+
+  // assign lanes and sort the cars by lane and s, call after the last add
+  void finish();
+
+  int lane_begin(int ln) const { return lane_start_[ln]; }
+  int lane_end(int ln) const { return lane_start_[ln + 1]; }
+
+private:
+  const LaneTopology *lanes_;  // a pointer keeps snapshots assignable
+  double ego_s_;
+  int capacity_;
+  int n_raw_;
+
+  // cars as they were added, finish() sorts them into the public arrays
+  int raw_id_[max_cars];
+  double raw_x_[max_cars], raw_y_[max_cars], raw_vx_[max_cars], raw_vy_[max_cars];
+  double raw_s_[max_cars], raw_d_[max_cars], raw_rel_s_[max_cars];
+  double raw_vs_[max_cars], raw_vd_[max_cars], raw_as_[max_cars], raw_ad_[max_cars];
+  int raw_lane_[max_cars];
+  int order_[max_cars];
+  int lane_start_[max_lanes + 1];
+};
+
+static_assert(std::is_trivially_copyable<TrafficSnapshot>::value,
+              "a snapshot is handed between threads by plain copies");
+
+#endif
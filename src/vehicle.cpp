@@ -1,4 +1,5 @@
 #include <iostream>
+#include <math.h>
 #include "vehicle.h"
 
 using std::cout;
@@ -28,22 +29,11 @@ Vehicle::Vehicle(int id, double x, double y, double s, double d, double v, State
 }
 
 
-Vehicle::~Vehicle(){}
-
-
-void Vehicle::find_lane(double d, int lane_width, int num_lane)
+void Vehicle::find_lane(double d, double lane_width, int num_lane)
 {
-
-  this->lane = 0;
-  int i=0;
-  while(i < num_lane)
-  {
-    if( d >= i*lane_width && d < (i+1)*lane_width)
-    {
-      this->lane = i;
-    }
-    ++i;
-  }
+  // lanes are lane_width wide from the center line, clamp cars off the road
+  int ln = (int)floor(d / lane_width);
+  this->lane = ln < 0 ? 0 : (ln >= num_lane ? num_lane - 1 : ln);
 
   if(d > num_lane*lane_width || d < 0)
   {
@@ -56,14 +46,20 @@ void Vehicle::find_lane(double d, int lane_width, int num_lane)
 }
 
 
-vector<State> Vehicle::successor_states()
+vector<State> Vehicle::successor_states(int num_lane)
 {
   vector<State> states;
-  states.push_back(State::KL);
-
   State cur_state = this->state;
   int cur_lane = this->lane;
 
+  // our lane ends ahead, the only way is to the left
+  if(cur_lane >= num_lane)
+  {
+    states.push_back(State::LCL);
+    return states;
+  }
+  states.push_back(State::KL);
+
   if(cur_state == State::KL)
   {
     if(cur_lane > 0)
@@ -71,7 +67,7 @@ vector<State> Vehicle::successor_states()
       states.push_back(State::LCL);
     }
 
-    if(cur_lane < 2)
+    if(cur_lane < num_lane - 1)
     {
       states.push_back(State::LCR);
     }
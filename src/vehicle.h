@@ -1,5 +1,6 @@
 #ifndef VEHICLE_H
 #define VEHICLE_H
+#include <type_traits>
 #include <vector>
 
 using std::vector;
@@ -36,18 +37,16 @@ public:
   Vehicle();
   Vehicle(int id, double x, double y, double s, double d, double v, State st=KL);
 
-  /*
-   * Destructor
-   */
-  virtual ~Vehicle();
-
   // find out the lane is in which lane
-  void find_lane(double d, int lane_width=4, int num_lane=3);
+  void find_lane(double d, double lane_width=4., int num_lane=3);
 
-  // Provides the possible next states given the current state for the FSM
-  vector<State> successor_states();
+  // Provides the possible next states given the current state for the FSM,
+  // num_lane is the number of lanes available ahead
+  vector<State> successor_states(int num_lane=3);
 
   
 };
 
+static_assert(std::is_trivially_copyable<Vehicle>::value, "a vehicle is copied like plain data");
+
 #endif
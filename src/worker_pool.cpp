@@ -0,0 +1,102 @@
+#include <algorithm>
+#include "worker_pool.h"
+
+/*
+ * Initialize WorkerPool
+ */
+
+WorkerPool::WorkerPool(int num_threads)
+{
+  if(num_threads < 0)
+    num_threads = std::max((int)std::thread::hardware_concurrency() - 1, 0);
+
+  stop_ = false;
+  generation_ = 0;
+  pending_ = 0;
+  job_ = nullptr;
+  n_ = 0;
+  chunk_ = 1;
+  next_ = 0;
+  for(int i = 0; i < num_threads; ++i)
+    workers_.push_back(std::thread(&WorkerPool::work, this));
+}
+
+
+WorkerPool::~WorkerPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  wake_.notify_all();
+  for(auto &w : workers_)
+    w.join();
+}
+
+
+void WorkerPool::run(int n, int chunk, const std::function<void(int, int)> &fn)
+{
+  if(n <= 0)
+    return;
+
+  // not worth waking anyone up
+  if(workers_.empty() || n <= chunk)
+  {
+    fn(0, n);
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    job_ = &fn;
+    n_ = n;
+    chunk_ = std::max(chunk, 1);
+    next_ = 0;
+    pending_ = workers_.size();
+    ++generation_;
+  }
+  wake_.notify_all();
+
+  take_chunks();
+
+  // every worker has to see the job, fn must outlive all of them
+  std::unique_lock<std::mutex> lock(mutex_);
+  done_.wait(lock, [this] { return pending_ == 0; });
+  job_ = nullptr;
+}
+
+
+void WorkerPool::take_chunks()
+{
+  for(;;)
+  {
+    int begin = next_.fetch_add(chunk_);
+    if(begin >= n_)
+      break;
+    (*job_)(begin, std::min(begin + chunk_, n_));
+  }
+}
+
+
+void WorkerPool::work()
+{
+  unsigned seen = 0;
+  for(;;)
+  {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      wake_.wait(lock, [this, seen] { return stop_ || generation_ != seen; });
+      if(stop_)
+        return;
+      seen = generation_;
+    }
+
+    take_chunks();
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      --pending_;
+    }
+    done_.notify_one();
+  }
+}
@@ -0,0 +1,53 @@
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using std::vector;
+
+/*
+ * A fixed set of threads for the data-parallel stages of a frame.
+ *
+ * The threads are started once and sleep between jobs, so a stage only
+ * pays for a wake-up, not for creating threads. run() splits [0, n) into
+ * chunks which the workers and the calling thread take in turn, and
+ * returns when all of them are done. Only one job runs at a time.
+ */
+class WorkerPool
+{
+public:
+  /*
+   * Constructor, -1 threads means one less than the hardware threads
+   */
+  WorkerPool(int num_threads=-1);
+  ~WorkerPool();
+
+  // number of threads working on a job, the caller included
+  int size() const { return workers_.size() + 1; }
+
+  // call fn(begin, end) for chunks of at most `chunk` items covering [0, n)
+  void run(int n, int chunk, const std::function<void(int, int)> &fn);
+
+private:
+  vector<std::thread> workers_;
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::condition_variable done_;
+  bool stop_;
+  unsigned generation_;  // counts the jobs, workers wait for a new one
+  int pending_;          // workers which haven't finished the current job
+
+  const std::function<void(int, int)> *job_;
+  int n_;
+  int chunk_;
+  std::atomic<int> next_;
+
+  void work();
+  void take_chunks();
+};
+
+#endif
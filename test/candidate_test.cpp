@@ -0,0 +1,84 @@
+#include <algorithm>
+#include <assert.h>
+#include <stdio.h>
+#include <vector>
+#include "../src/candidate.h"
+#include "../src/feasibility.h"
+
+using std::vector;
+
+/*
+ * Branch-and-bound over candidates whose exact cost adds the feasibility
+ * margin of their path to their bound. The candidate with the lowest
+ * bound swerves hard and loses to a straight one, and a candidate whose
+ * bound is above the best exact cost is never evaluated, unless a batched
+ * stage rejects the candidate it was left out for.
+ */
+int main()
+{
+  const int n_points = 50;
+  const double dt = 0.02, v = 20.;
+  vector<double> straight_x, straight_y, swerve_x, swerve_y;
+  for(int k = 0; k < n_points; ++k)
+  {
+    double t = (k + 1) * dt;
+    straight_x.push_back(v * t);
+    straight_y.push_back(0.);
+    // 6 m/s^2 across the road, within the limits but far from calm
+    swerve_x.push_back(v * t);
+    swerve_y.push_back(3. * t * t);
+  }
+
+  CandidateBatch batch(4, n_points);
+  FeasibilityChecker feasibility;
+  StageMetrics metrics;
+  metrics.reset();
+  int swerve = batch.add(State::LCL, 0, 1.);
+  int calm = batch.add(State::KL, 1, 2.);
+  int far = batch.add(State::LCR, 2, 100.);
+  batch.set_path(swerve, swerve_x, swerve_y);
+  batch.set_path(calm, straight_x, straight_y);
+  batch.set_path(far, straight_x, straight_y);
+
+  vector<int> evaluated;
+  int best = branch_and_bound(batch, metrics, [&](int c)
+  {
+    evaluated.push_back(c);
+    batch.survivors.assign(1, c);
+    if(feasibility.filter(batch) == 0)
+      return 1e9;
+    return batch.bound[c] + feasibility.margin_cost(c);
+  }, [](CandidateBatch &) {});
+
+  assert(batch.cost[swerve] >= batch.bound[swerve]);
+  assert(batch.cost[calm] >= batch.bound[calm]);
+  assert(batch.cost[swerve] > batch.cost[calm]);
+  assert(best == calm);
+  assert(evaluated.size() == 2);
+  assert(metrics.pruned == 1);
+
+  // the batched stage rejects the calm path, so the candidate left out
+  // because of it gets evaluated after all
+  batch.bound[far] = 3.;
+  metrics.reset();
+  evaluated.clear();
+  best = branch_and_bound(batch, metrics, [&](int c)
+  {
+    evaluated.push_back(c);
+    batch.survivors.assign(1, c);
+    if(feasibility.filter(batch) == 0)
+      return 1e9;
+    return batch.bound[c] + feasibility.margin_cost(c);
+  }, [&](CandidateBatch &b)
+  {
+    auto last = std::remove(b.survivors.begin(), b.survivors.end(), calm);
+    b.survivors.erase(last, b.survivors.end());
+  });
+
+  assert(best == far);
+  assert(evaluated.size() == 3);
+  assert(metrics.pruned == 0);
+
+  printf("candidate_test passed\n");
+  return 0;
+}
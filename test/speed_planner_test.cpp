@@ -0,0 +1,41 @@
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include "../src/speed_planner.h"
+
+/*
+ * Speed profiles from standstill or near it under strong braking, where
+ * every braking step ends below the lowest speed level. The plan has to
+ * come to a stop and stay there instead of reading states no profile
+ * reaches.
+ */
+int main()
+{
+  const double max_s = 6945.554;
+  SpeedPlanner planner(max_s);
+  Prediction empty;
+  planner.set_obstacles(empty, 0., 0., 0., 12.);
+
+  // a plan at speed first, so parents of an earlier frame are around
+  planner.plan(20., 0.);
+
+  const double starts[][2] = {{0., -5.}, {0., -7.}, {0.1, -3.}, {0., -3.}, {1., -7.}, {2., -7.}};
+  for(const auto &start : starts)
+  {
+    planner.plan(start[0], start[1]);
+    double s_prev = 0.;
+    for(int k = 0; k <= planner.num_steps; ++k)
+    {
+      double t = k * planner.dt;
+      double v = planner.speed_at(t);
+      double s = planner.s_at(t);
+      assert(isfinite(v) && isfinite(s));
+      assert(v >= 0. && v <= planner.v_max + 1.);
+      assert(s >= s_prev - 1e-6);
+      s_prev = s;
+    }
+  }
+
+  printf("speed_planner_test passed\n");
+  return 0;
+}
@@ -0,0 +1,99 @@
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <math.h>
+#include <vector>
+#include "../src/motion_primitive.h"
+
+using namespace std;
+
+/*
+ * Generates the motion primitive library.
+ *
+ *   primitive_gen [file]   (default ../data/motion_primitives.bin)
+ *
+ * Every combination of start speed, end speed, lateral offset and horizon
+ * gets its minimum-jerk polynomials and their peaks, sampled at the path
+ * step of 0.02 s.
+ */
+
+// second and third derivative of a quintic at t
+static double acc(const float *c, double t)
+{
+  return 2. * c[2] + t * (6. * c[3] + t * (12. * c[4] + t * 20. * c[5]));
+}
+
+static double jerk(const float *c, double t)
+{
+  return 6. * c[3] + t * (24. * c[4] + t * 60. * c[5]);
+}
+
+int main(int argc, char **argv)
+{
+  const char *file = argc > 1 ? argv[1] : "../data/motion_primitives.bin";
+
+  MotionPrimitiveHeader h;
+  memset(&h, 0, sizeof(h));
+  memcpy(h.magic, "PRIM", 4);
+  h.version = 1;
+  h.n_v0 = 23;  h.v0_min = 0.f;        h.v0_step = 1.f;
+  h.n_v1 = 23;  h.v1_min = 0.f;        h.v1_step = 1.f;
+  h.n_offset = 9;  h.offset_min = -8.f;  h.offset_step = 2.f;
+  h.n_horizon = 6; h.horizon_min = 1.f;  h.horizon_step = 0.5f;
+  h.max_acc = 10.f;
+  h.max_jerk = 10.f;
+
+  vector<MotionPrimitive> prims;
+  prims.reserve(h.n_v0 * h.n_v1 * h.n_offset * h.n_horizon);
+  int n_feasible = 0;
+  for(int i0 = 0; i0 < h.n_v0; ++i0)
+  for(int i1 = 0; i1 < h.n_v1; ++i1)
+  for(int io = 0; io < h.n_offset; ++io)
+  for(int ih = 0; ih < h.n_horizon; ++ih)
+  {
+    double v0 = h.v0_min + i0 * h.v0_step;
+    double v1 = h.v1_min + i1 * h.v1_step;
+    double offset = h.offset_min + io * h.offset_step;
+    double T = h.horizon_min + ih * h.horizon_step;
+
+    MotionPrimitive p;
+    memset(&p, 0, sizeof(p));
+    // the speed is reached with zero acceleration at both ends
+    double sc[6], dc[6];
+    min_jerk_quintic(0., v0, 0., 0.5 * (v0 + v1) * T, v1, 0., T, sc);
+    min_jerk_quintic(0., 0., 0., offset, 0., 0., T, dc);
+    for(int i = 0; i < 6; ++i)
+    {
+      p.s_coef[i] = sc[i];
+      p.d_coef[i] = dc[i];
+    }
+
+    for(double t = 0.; t <= T + 1e-9; t += 0.02)
+    {
+      double al = acc(p.s_coef, t), ad = acc(p.d_coef, t);
+      double jl = jerk(p.s_coef, t), jd = jerk(p.d_coef, t);
+      p.peak_lon_acc = max(p.peak_lon_acc, (float)fabs(al));
+      p.peak_lat_acc = max(p.peak_lat_acc, (float)fabs(ad));
+      p.peak_acc = max(p.peak_acc, (float)sqrt(al * al + ad * ad));
+      p.peak_jerk = max(p.peak_jerk, (float)sqrt(jl * jl + jd * jd));
+    }
+    p.feasible = (p.peak_acc <= h.max_acc && p.peak_jerk <= h.max_jerk) ? 1 : 0;
+    n_feasible += p.feasible;
+    prims.push_back(p);
+  }
+
+  FILE *f = fopen(file, "wb");
+  if(!f)
+  {
+    cerr << "can't write " << file << endl;
+    return 1;
+  }
+  fwrite(&h, sizeof(h), 1, f);
+  fwrite(prims.data(), sizeof(MotionPrimitive), prims.size(), f);
+  fclose(f);
+
+  cout << prims.size() << " primitives (" << n_feasible << " feasible), "
+    << sizeof(h) + prims.size() * sizeof(MotionPrimitive) << " bytes written to " << file << endl;
+
+  return 0;
+}